@@ -0,0 +1,68 @@
+#ifndef BLOOM_FILTER_HPP
+#define BLOOM_FILTER_HPP
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+
+// Fixed-size Bloom filter a node agent uses to advertise the input keys held
+// in its local cache. Hashing is FNV-1a so manager and node agree on the bits
+// regardless of the standard library they were built with.
+class BloomFilter {
+public:
+    static const size_t BITS = 1024;
+    static const int HASHES = 3;
+
+    void add(const std::string& key) {
+        for (int i = 0; i < HASHES; ++i) bits.set(index(key, i));
+    }
+
+    bool might_contain(const std::string& key) const {
+        for (int i = 0; i < HASHES; ++i) {
+            if (!bits.test(index(key, i))) return false;
+        }
+        return true;
+    }
+
+    bool empty() const { return bits.none(); }
+
+    std::string to_hex() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(BITS / 4);
+        for (size_t i = 0; i < BITS; i += 4) {
+            int nibble = bits[i] | bits[i + 1] << 1 | bits[i + 2] << 2 | bits[i + 3] << 3;
+            hex += digits[nibble];
+        }
+        return hex;
+    }
+
+    // Malformed input yields an empty filter.
+    static BloomFilter from_hex(const std::string& hex) {
+        BloomFilter filter;
+        if (hex.size() != BITS / 4) return filter;
+        for (size_t n = 0; n < hex.size(); ++n) {
+            char c = hex[n];
+            int nibble = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (nibble < 0) return BloomFilter();
+            for (int b = 0; b < 4; ++b) {
+                if (nibble & (1 << b)) filter.bits.set(n * 4 + b);
+            }
+        }
+        return filter;
+    }
+
+private:
+    std::bitset<BITS> bits;
+
+    static size_t index(const std::string& key, int seed) {
+        uint64_t hash = 1469598103934665603ULL ^ (uint64_t)(seed + 1) * 0x9e3779b97f4a7c15ULL;
+        for (unsigned char c : key) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash % BITS;
+    }
+};
+
+#endif
@@ -3,15 +3,218 @@
 #include <thread>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <cstring>
 #include <random>
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <sstream>
+#include <vector>
 
 #define BUFFER_SIZE 1024
 
+int connect_to_manager(const std::string& manager_ip, int manager_port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        std::cerr << "Error creating socket\n";
+        return -1;
+    }
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(manager_port);
+    inet_pton(AF_INET, manager_ip.c_str(), &server_addr.sin_addr);
+
+    if (connect(sock, (sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Returns the retry_after_ms hint of a REJECTED/BUSY reply, 0 if accepted,
+// or -1 for a rejection without a hint, which must not be retried.
+long parse_retry_after(const std::string& reply) {
+    if (reply.rfind("REJECTED", 0) != 0 && reply.rfind("BUSY", 0) != 0) return 0;
+    size_t pos = reply.find("retry_after_ms=");
+    if (pos == std::string::npos) return reply.rfind("REJECTED", 0) == 0 ? -1 : 1000;
+    return std::max(1L, std::stol(reply.substr(pos + 15)));
+}
+
+// Sends one task and honours the manager's backpressure replies by waiting
+// the advertised retry_after_ms before resubmitting.
+bool submit_with_retry(const std::string& manager_ip, int manager_port, const std::string& task) {
+    const int max_attempts = 10;
+    for (int attempt = 1; attempt <= max_attempts; ++attempt) {
+        int sock = connect_to_manager(manager_ip, manager_port);
+        if (sock < 0) {
+            std::cerr << "Connection to manager failed for " << task << "\n";
+            return false;
+        }
+
+        std::string msg = task + "\n";
+        send(sock, msg.c_str(), msg.size(), 0);
+        shutdown(sock, SHUT_WR);
+
+        std::string reply;
+        char buffer[BUFFER_SIZE];
+        ssize_t n;
+        while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+            reply.append(buffer, n);
+        }
+        close(sock);
+
+        long retry_after = parse_retry_after(reply);
+        if (retry_after == 0) return true;
+        std::cout << "[CLIENT] " << reply.substr(0, reply.find('\n')) << " (attempt " << attempt << ")\n";
+        if (retry_after < 0) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(retry_after));
+    }
+    return false;
+}
+
+// Sends data on a fresh connection, half-closes it and returns everything
+// the manager answers until it closes. Returns false if it cannot connect.
+bool exchange(const std::string& manager_ip, int manager_port, const std::string& msg, std::string& reply) {
+    int sock = connect_to_manager(manager_ip, manager_port);
+    if (sock < 0) return false;
+    send(sock, msg.c_str(), msg.size(), 0);
+    shutdown(sock, SHUT_WR);
+
+    char buffer[BUFFER_SIZE];
+    ssize_t n;
+    while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+        reply.append(buffer, n);
+    }
+    close(sock);
+    return true;
+}
+
+// Submits the batch in slices of about the manager's per-client burst,
+// resubmitting tasks it refuses after their retry_after_ms, then watches
+// every accepted task over a single connection and blocks on the pushed
+// completion events instead of polling the status port. Gives up on the
+// rest after max_stalled slices in a row are refused entirely. Returns
+// non-zero if any task was never accepted or its completion was not
+// reported.
+int submit_and_wait(const std::string& manager_ip, int manager_port, const std::vector<std::string>& task_lines) {
+    const size_t slice_size = 200;
+    const int max_stalled = 10;
+    std::deque<std::string> pending(task_lines.begin(), task_lines.end());
+    std::vector<std::string> accepted;
+    size_t failed = 0;
+
+    for (int stalled = 0, attempt = 1; stalled < max_stalled && !pending.empty(); ++attempt) {
+        size_t count = std::min(slice_size, pending.size());
+        std::vector<std::string> slice(pending.begin(), pending.begin() + count);
+        pending.erase(pending.begin(), pending.begin() + count);
+        std::string msg;
+        for (const auto& line : slice) msg += line + "\n";
+        std::string reply;
+        if (!exchange(manager_ip, manager_port, msg, reply)) {
+            std::cerr << "Connection to manager failed\n";
+            return 1;
+        }
+
+        long retry_after = 0;
+        std::vector<std::string> refused;
+        if (reply.rfind("BUSY", 0) == 0) {
+            retry_after = parse_retry_after(reply);
+            refused = slice;
+        } else {
+            std::istringstream lines(reply);
+            std::string line;
+            std::set<std::string> refused_ids, failed_ids;
+            while (std::getline(lines, line)) {
+                long wait_ms = parse_retry_after(line);
+                if (wait_ms == 0) continue;
+                std::cout << "[CLIENT] " << line << " (attempt " << attempt << ")\n";
+                std::istringstream fields(line);
+                std::string tag, task_id;
+                fields >> tag >> task_id;
+                (wait_ms < 0 ? failed_ids : refused_ids).insert(task_id);
+                retry_after = std::max(retry_after, wait_ms);
+            }
+            for (const auto& task_line : slice) {
+                std::string task_id = task_line.substr(0, task_line.find(':'));
+                if (failed_ids.count(task_id)) failed++;
+                else if (refused_ids.count(task_id)) refused.push_back(task_line);
+                else accepted.push_back(task_id);
+            }
+        }
+
+        // Refused tasks go back to the front, in order, ahead of the rest.
+        stalled = refused.size() == slice.size() ? stalled + 1 : 0;
+        pending.insert(pending.begin(), refused.begin(), refused.end());
+        if (!refused.empty() && stalled < max_stalled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(retry_after));
+        }
+    }
+
+    for (const auto& task_line : pending) {
+        std::cerr << "[CLIENT] Giving up on " << task_line.substr(0, task_line.find(':')) << "\n";
+    }
+    if (accepted.empty()) return 1;
+
+    std::string watch = "WATCH";
+    for (const auto& task_id : accepted) watch += " " + task_id;
+    watch += "\n";
+
+    int sock = -1;
+    for (int attempt = 1; attempt <= max_stalled; ++attempt) {
+        sock = connect_to_manager(manager_ip, manager_port);
+        if (sock < 0) {
+            std::cerr << "Connection to manager failed\n";
+            return 1;
+        }
+        send(sock, watch.c_str(), watch.size(), 0);
+        shutdown(sock, SHUT_WR);
+
+        // A BUSY reply is the only thing sent before the manager closes.
+        char first[BUFFER_SIZE];
+        ssize_t n = recv(sock, first, sizeof(first), MSG_PEEK);
+        std::string head = n > 0 ? std::string(first, n) : "";
+        if (head.rfind("BUSY", 0) != 0) break;
+        close(sock);
+        sock = -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(parse_retry_after(head)));
+    }
+    if (sock < 0) {
+        std::cerr << "[CLIENT] Manager too busy to accept the completion watch\n";
+        return 1;
+    }
+
+    std::string buffered;
+    char buffer[BUFFER_SIZE];
+    ssize_t n;
+    bool all_done = false;
+    int unknown = 0;
+    while (!all_done && (n = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+        buffered.append(buffer, n);
+        size_t pos;
+        while ((pos = buffered.find('\n')) != std::string::npos) {
+            std::string line = buffered.substr(0, pos);
+            buffered.erase(0, pos + 1);
+            std::cout << "[CLIENT] " << line << "\n";
+            if (line.rfind("UNKNOWN", 0) == 0) unknown++;
+            if (line.rfind("ALL_DONE", 0) == 0) all_done = true;
+        }
+    }
+    close(sock);
+
+    if (!all_done) {
+        std::cerr << "[CLIENT] Manager closed the connection before all tasks completed\n";
+        return 1;
+    }
+    return pending.empty() && failed == 0 && unknown == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <manager_ip> <manager_port> <number_of_tasks>\n";
+    bool wait = argc == 5 && std::string(argv[4]) == "--wait";
+    if (argc != 4 && !wait) {
+        std::cerr << "Usage: " << argv[0] << " <manager_ip> <manager_port> <number_of_tasks> [--wait]\n";
         return 1;
     }
 
@@ -23,32 +226,26 @@ int main(int argc, char* argv[]) {
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> mem_dist(6, 126);
 
+    std::vector<std::string> batch;
     for (int i = 1; i <= num_tasks; ++i) {
         int mem_req = mem_dist(gen);
-        int sock = socket(AF_INET, SOCK_STREAM, 0);
-        if (sock < 0) {
-            std::cerr << "Error creating socket\n";
-            continue;
-        }
-
-        sockaddr_in server_addr{};
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(manager_port);
-        inet_pton(AF_INET, manager_ip.c_str(), &server_addr.sin_addr);
+        std::string task = "Task_" + std::to_string(i) + ":Workload_" + std::to_string(i) + ":" + std::to_string(mem_req) + "mb"; // random MB, no dependencies
 
-        if (connect(sock, (sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-            std::cerr << "Connection to manager failed for Task_" << i << "\n";
-            close(sock);
+        if (wait) {
+            batch.push_back(task);
+            std::cout << "[CLIENT] Queued: " << task << "\n";
             continue;
         }
 
-        std::string task = "Task_" + std::to_string(i) + ":Workload_" + std::to_string(i) + ":" + std::to_string(mem_req) + "mb"; // random MB, no dependencies
-        send(sock, task.c_str(), task.size(), 0);
-        close(sock);
-        std::cout << "[CLIENT] Sent: " << task << "\n";
+        if (submit_with_retry(manager_ip, manager_port, task)) {
+            std::cout << "[CLIENT] Sent: " << task << "\n";
+        } else {
+            std::cerr << "[CLIENT] Giving up on Task_" << i << "\n";
+        }
 
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
+    if (wait) return submit_and_wait(manager_ip, manager_port, batch);
     return 0;
-}
\ No newline at end of file
+}
@@ -27,7 +27,8 @@ std::vector<std::string> split(const std::string& s, char delim) {
     return elems;
 }
 
-void print_dashboard(const std::vector<NodeInfo>& nodes, const std::vector<TaskInfo>& tasks) {
+void print_dashboard(const std::vector<NodeInfo>& nodes, const std::vector<TaskInfo>& tasks,
+                     const std::vector<std::pair<std::string, std::string>>& stats) {
     system("clear");
     std::cout << "+------------------- Nodes -----------------------------+\n";
     std::cout << "| ID     | IP         | Port | Mem(MB) | Health |\n";
@@ -52,6 +53,9 @@ void print_dashboard(const std::vector<NodeInfo>& nodes, const std::vector<TaskI
                   << "| " << t.memory_required << std::string(8-std::to_string(t.memory_required).size(),' ') << "|\n";
     }
     std::cout << "+---------------------------------------------+\n";
+    for (const auto& [name, value] : stats) {
+        std::cout << "  " << name << ": " << value << "\n";
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -93,6 +97,7 @@ int main(int argc, char* argv[]) {
             std::string line, section;
             std::vector<NodeInfo> nodes;
             std::vector<TaskInfo> tasks;
+            std::vector<std::pair<std::string, std::string>> stats;
             const size_t MAX_LINE_LEN = 1024;
             const size_t MAX_LINES = 10000;
             size_t line_count = 0;
@@ -101,6 +106,7 @@ int main(int argc, char* argv[]) {
                 if (line.length() > MAX_LINE_LEN) continue;
                 if (line == "NODES") { section = "NODES"; continue; }
                 if (line == "TASKS") { section = "TASKS"; continue; }
+                if (line == "STATS") { section = "STATS"; continue; }
                 if (section == "NODES" && !line.empty()) {
                     auto fields = split(line, ',');
                     if (fields.size() != 5) continue; // id, ip, port, mem, health
@@ -114,9 +120,13 @@ int main(int argc, char* argv[]) {
                     int mem_val = 0;
                     try { mem_val = std::stoi(fields[3]); } catch (...) { mem_val = 0; }
                     tasks.push_back({fields[0], fields[1], fields[2], mem_val});
+                } else if (section == "STATS" && !line.empty()) {
+                    auto fields = split(line, ',');
+                    if (fields.size() != 2) continue; // name, value
+                    stats.push_back({fields[0], fields[1]});
                 }
             }
-            print_dashboard(nodes, tasks);
+            print_dashboard(nodes, tasks, stats);
         } catch (const std::exception& e) {
             std::cerr << "[DASHBOARD] Exception: " << e.what() << std::endl;
             // Sleep to avoid tight error loop
@@ -1,5 +1,6 @@
 // ===== manager.cpp =====
 #include <arpa/inet.h>
+#include <cerrno>
 #include <csignal>
 #include <cstring>
 #include <fcntl.h>
@@ -8,10 +9,12 @@
 #include <map>
 #include <mutex>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sstream>
 #include <streambuf>
 #include <string>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <thread>
 #include <unistd.h>
 #include <queue>
@@ -19,11 +22,59 @@
 #include <atomic>
 #include <ctime>
 #include <set>
+#include <chrono>
+#include <deque>
+#include <algorithm>
+#include <condition_variable>
+#include "../../include/bloom_filter.hpp"
 
 std::mutex node_mutex;
 std::mutex task_mutex;
 std::atomic<bool> running{true};
 
+// Admission control limits
+const size_t MAX_QUEUED_TASKS = 1000;       // hard bound on ready + delayed tasks
+const size_t MAX_RETAINED_COMPLETED = 5000; // completed entries kept for status/dedup
+const int MAX_CLIENT_HANDLERS = 64;         // concurrent client connection threads
+const size_t MAX_SUBSCRIBERS = 256;         // open completion streams
+const int SUBSCRIBER_PROBE_MS = 5000;       // PENDING heartbeat / dead subscriber check
+const double CLIENT_RATE_PER_SEC = 50.0;    // token bucket refill per client IP
+const double CLIENT_BURST = 200.0;          // token bucket capacity per client IP
+const long SCHEDULER_TICK_MS = 200;
+const long MAX_SCHEDULER_LAG_MS = 1000;     // beyond this the manager is overloaded
+const int CLIENT_RECV_TIMEOUT_SEC = 5;
+const int CLIENT_SEND_TIMEOUT_SEC = 5;
+const int NODE_POLL_TIMEOUT_MS = 1000;  // bounds how long a node handler misses shutdown
+const int NODE_CONNECT_TIMEOUT_MS = 1000;   // dispatch and health probe connects
+const int NODE_SEND_TIMEOUT_SEC = 2;        // writes on a node's persistent dispatch stream
+const long NODE_SILENCE_MS = 5000;          // no report for this long marks a node DOWN
+
+// Micro-task batching
+const int SMALL_TASK_MB = 64;             // tasks at or below this may share a dispatch
+const size_t MAX_BATCH_SIZE = 32;
+const long BATCH_LAG_TARGET_MS = 100;     // scheduler lag past this widens batches
+
+// Speculative re-execution of stragglers
+const size_t RUNTIME_HISTORY = 100;       // recent run times kept per workload class
+const size_t MIN_RUNTIME_SAMPLES = 5;     // no speculation before this many samples
+const double STRAGGLER_FACTOR = 2.0;      // straggler: running longer than this x p90
+const long MIN_SPECULATION_MS = 3000;
+
+// Data-locality-aware placement
+const long LOCALITY_WAIT_MS = 1000;       // how long a task may wait for a warm node
+
+// Memory overcommit from observed usage
+const size_t USAGE_HISTORY = 200;         // recent usage ratios kept per workload class
+const size_t MIN_USAGE_SAMPLES = 10;      // reserve the full declaration until then
+const double USAGE_PERCENTILE = 0.95;     // reserve for this percentile of observed usage
+const double USAGE_SAFETY_MARGIN = 1.2;
+const double NODE_PRESSURE_RATIO = 0.85;  // no new work while node RSS is above this share
+double overcommit_ratio = 2.0;            // max declared/capacity per node; 1.0 disables
+
+std::atomic<long> scheduler_lag_ms{0};
+std::atomic<int> active_client_handlers{0};
+std::string local_socket_path;  // Unix socket co-located node agents register on
+
 struct NodeInfo {
     std::string id;
     std::string ip;
@@ -31,9 +82,15 @@ struct NodeInfo {
     int sockfd;
     int available_memory = 0; // in MB
     std::string health_status = "UP";
+    std::string local_path;  // Unix socket of a co-located node; empty means TCP only
+    int dispatch_fd = -1;    // persistent Unix dispatch stream to a co-located node
+    BloomFilter input_cache; // input keys the node reports as cached
+    int total_memory = 0;    // capacity announced at registration, in MB
+    int rss_memory = 0;      // resident memory the node last reported, in MB
+    std::chrono::steady_clock::time_point last_heard = std::chrono::steady_clock::now();  // agents report every second
 };
 
-enum class TaskStatus { QUEUED, ASSIGNED, COMPLETED };
+enum class TaskStatus { QUEUED, ASSIGNED, COMPLETED, EXPIRED };
 
 struct TaskEntry {
     std::string task;
@@ -41,11 +98,75 @@ struct TaskEntry {
     std::string assigned_node;
     int memory_required; // in MB
     std::vector<std::string> dependencies; // task IDs this task depends on
+    std::string workload;                  // used to group similar tasks for run time stats
+    std::string speculative_node;          // node running a speculative copy, if any
+    std::vector<std::string> inputs;       // input data keys, for cache-aware placement
+    std::chrono::steady_clock::time_point locality_wait_since{};  // first deferred for a warm node
+    int reserved_memory = 0;               // MB charged against the node while assigned
+    std::chrono::steady_clock::time_point submitted_at{};
+    std::chrono::steady_clock::time_point assigned_at{};
+    std::chrono::steady_clock::time_point started_at{};     // dispatch of the copy counted as primary
+    std::chrono::steady_clock::time_point speculated_at{};  // dispatch of the speculative copy
+    std::chrono::steady_clock::time_point completed_at{};
+    // Optional timing constraints; a zero time_point means "not set".
+    std::chrono::steady_clock::time_point not_before{};  // held back until then
+    std::chrono::steady_clock::time_point deadline{};    // EDF key, should finish by then
+    std::chrono::steady_clock::time_point expires_at{};  // dropped if not started by then
+    bool deadline_missed = false;                        // already counted in deadlines_missed
+};
+
+struct DeadlineItem {
+    std::chrono::steady_clock::time_point deadline;
+    unsigned long seq;  // FIFO among equal deadlines
+    std::string task_id;
+    bool operator>(const DeadlineItem &other) const {
+        return deadline != other.deadline ? deadline > other.deadline : seq > other.seq;
+    }
+};
+
+// A client connection kept open to receive pushed completion events.
+// Guarded by task_mutex, since it is only touched alongside task state.
+struct Subscriber {
+    int sockfd;
+    std::set<std::string> pending; // watched task IDs not yet completed
+    int delivered = 0;
+    // While the client handler is still writing the initial replay, events
+    // are queued here for it to send, so no other thread writes the socket.
+    bool replaying = false;
+    std::string backlog;
 };
 
 std::map<std::string, NodeInfo> nodes;
-std::queue<std::string> task_queue;
+std::deque<std::string> task_queue;  // best-effort work, FIFO
+std::priority_queue<DeadlineItem, std::vector<DeadlineItem>, std::greater<DeadlineItem>> deadline_queue;  // EDF
+unsigned long deadline_seq = 0;
+// Timers for delayed release, expiry and deadlines, guarded by task_mutex and served by
+// timer_loop(), which sleeps until the earliest one is due.
+std::multimap<std::chrono::steady_clock::time_point, std::string> delayed_releases;
+std::multimap<std::chrono::steady_clock::time_point, std::string> expiry_timers;
+std::multimap<std::chrono::steady_clock::time_point, std::string> deadline_timers;
+std::condition_variable timer_cv;
+unsigned long deadlines_met = 0;
+unsigned long deadlines_missed = 0;
+unsigned long tasks_expired = 0;
+std::map<std::string, std::deque<long>> runtime_history;  // workload class -> recent run times (ms)
+unsigned long speculations_launched = 0;
+unsigned long speculations_won = 0;
+unsigned long locality_hits = 0;    // input tasks placed on a node with warm inputs
+unsigned long locality_misses = 0;  // input tasks placed cold
+std::map<std::string, std::deque<double>> usage_history;  // workload class -> observed/declared memory
+unsigned long tasks_evicted = 0;
 std::map<std::string, TaskEntry> tasks;  // Task -> Entry
+std::map<int, Subscriber> subscribers;                 // sockfd -> Subscriber
+std::map<std::string, std::set<int>> task_watchers;    // Task -> subscriber sockets
+
+struct TokenBucket {
+    double tokens = CLIENT_BURST;
+    std::chrono::steady_clock::time_point last_refill = std::chrono::steady_clock::now();
+};
+
+std::map<std::string, TokenBucket> client_buckets;  // client IP -> bucket, guarded by task_mutex
+std::deque<std::string> completed_order;           // completion order, for pruning tasks
 
 // Custom streambuf that duplicates output to two streambufs
 class TeeBuf : public std::streambuf {
@@ -77,76 +198,737 @@ void log(const std::string &level, const std::string &msg) {
     std::cout << buf << " [" << level << "]    " << msg << std::endl;
 }
 
+// Connects sockfd within NODE_CONNECT_TIMEOUT_MS and closes it on failure,
+// so a wedged node cannot block the caller. A Unix socket whose accept
+// backlog is full fails at once instead of waiting for the node to accept.
+int connect_with_timeout(int sockfd, const sockaddr *addr, socklen_t len) {
+    int flags = fcntl(sockfd, F_GETFL, 0);
+    fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
+    bool connected = connect(sockfd, addr, len) == 0;
+    if (!connected && errno == EINPROGRESS) {
+        pollfd pfd{sockfd, POLLOUT, 0};
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        connected = poll(&pfd, 1, NODE_CONNECT_TIMEOUT_MS) == 1 &&
+                    getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &error_len) == 0 && error == 0;
+    }
+    if (!connected) {
+        close(sockfd);
+        return -1;
+    }
+    fcntl(sockfd, F_SETFL, flags);
+    return sockfd;
+}
+
+int connect_local(const std::string &path) {
+    sockaddr_un local_addr{};
+    local_addr.sun_family = AF_UNIX;
+    strncpy(local_addr.sun_path, path.c_str(), sizeof(local_addr.sun_path) - 1);
+    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sockfd < 0) return -1;
+    return connect_with_timeout(sockfd, (sockaddr *)&local_addr, sizeof(local_addr));
+}
+
+// Opens a connection to a node, preferring its Unix socket when the node is
+// co-located and falling back to TCP. Returns -1 on failure.
+int connect_to_node(const NodeInfo &node) {
+    if (!node.local_path.empty()) {
+        int sockfd = connect_local(node.local_path);
+        if (sockfd >= 0) return sockfd;
+    }
+
+    sockaddr_in node_addr{};
+    node_addr.sin_family = AF_INET;
+    node_addr.sin_port = htons(node.port);
+    inet_pton(AF_INET, node.ip.c_str(), &node_addr.sin_addr);
+
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) return -1;
+    return connect_with_timeout(sockfd, (sockaddr *)&node_addr, sizeof(node_addr));
+}
+
+// Caller must hold node_mutex. Socket for the next message to a node. A
+// co-located node keeps one persistent Unix dispatch stream, opened on first
+// use; other nodes get a fresh connection per message. Returns -1 if the
+// node cannot be reached.
+int open_channel(NodeInfo &node) {
+    if (node.dispatch_fd >= 0) return node.dispatch_fd;
+    if (!node.local_path.empty()) {
+        node.dispatch_fd = connect_local(node.local_path);
+        if (node.dispatch_fd >= 0) {
+            // A stopped node must not block dispatch once the stream fills.
+            timeval tv{NODE_SEND_TIMEOUT_SEC, 0};
+            setsockopt(node.dispatch_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            return node.dispatch_fd;
+        }
+    }
+    return connect_to_node(node);
+}
+
+// Caller must hold node_mutex.
+void close_channel(NodeInfo &node) {
+    if (node.dispatch_fd < 0) return;
+    close(node.dispatch_fd);
+    node.dispatch_fd = -1;
+}
+
+// Caller must hold node_mutex. Sends one message, newline-terminated, on a
+// socket from open_channel and closes it unless it is the node's persistent
+// stream. A broken stream (e.g. the node agent restarted) is reopened and
+// the message retried once.
+bool send_on_channel(NodeInfo &node, int sockfd, const std::string &msg) {
+    std::string line = msg + "\n";
+    bool sent = send(sockfd, line.c_str(), line.size(), MSG_NOSIGNAL) == (ssize_t)line.size();
+    if (sockfd != node.dispatch_fd) {
+        close(sockfd);
+        return sent;
+    }
+    if (sent) return true;
+    close_channel(node);
+    sockfd = open_channel(node);
+    if (sockfd < 0) return false;
+    sent = send(sockfd, line.c_str(), line.size(), MSG_NOSIGNAL) == (ssize_t)line.size();
+    if (sockfd != node.dispatch_fd) close(sockfd);
+    else if (!sent) close_channel(node);
+    return sent;
+}
+
+// Caller must hold node_mutex.
+bool send_to_node(NodeInfo &node, const std::string &msg) {
+    int sockfd = open_channel(node);
+    return sockfd >= 0 && send_on_channel(node, sockfd, msg);
+}
+
+// Peer address of an accepted socket; connections on the Unix listener are
+// reported as loopback since they can only come from this host.
+std::string peer_ip(int sockfd) {
+    sockaddr_storage addr{};
+    socklen_t len = sizeof(addr);
+    if (getpeername(sockfd, (sockaddr *)&addr, &len) == 0 && addr.ss_family == AF_INET) {
+        return inet_ntoa(((sockaddr_in *)&addr)->sin_addr);
+    }
+    return "127.0.0.1";
+}
+
 void signal_handler(int signum) {
     log("INFO", "Caught signal " + std::to_string(signum) + ". Shutting down manager...");
     running = false;
 
     std::lock_guard<std::mutex> lock(node_mutex);
     for (auto &[id, node] : nodes) {
-        std::string shutdown_msg = "SHUTDOWN";
-        sockaddr_in node_addr{};
-        node_addr.sin_family = AF_INET;
-        node_addr.sin_port = htons(node.port);
-        inet_pton(AF_INET, node.ip.c_str(), &node_addr.sin_addr);
-
-        int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-        if (sockfd >= 0 && connect(sockfd, (sockaddr *)&node_addr, sizeof(node_addr)) == 0) {
-            send(sockfd, shutdown_msg.c_str(), shutdown_msg.size(), 0);
-            close(sockfd);
-        }
+        send_to_node(node, "SHUTDOWN");
     }
+    if (!local_socket_path.empty()) unlink(local_socket_path.c_str());
 
     log("INFO", "Manager: Shutdown complete.");
     exit(0);
 }
 
+long ms_between(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    if (from == std::chrono::steady_clock::time_point{} || to < from) return 0;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+
+std::string status_name(TaskStatus status) {
+    switch (status) {
+        case TaskStatus::QUEUED: return "QUEUED";
+        case TaskStatus::ASSIGNED: return "ASSIGNED";
+        case TaskStatus::COMPLETED: return "COMPLETED";
+        case TaskStatus::EXPIRED: return "EXPIRED";
+    }
+    return "UNKNOWN";
+}
+
+bool is_terminal(TaskStatus status) {
+    return status == TaskStatus::COMPLETED || status == TaskStatus::EXPIRED;
+}
+
+std::string completion_event(const std::string &task_id, const TaskEntry &entry) {
+    std::string event = "DONE " + task_id + " " + status_name(entry.status) + " " +
+                        (entry.assigned_node.empty() ? "-" : entry.assigned_node) +
+                        " wait_ms=" + std::to_string(ms_between(entry.submitted_at, entry.assigned_at)) +
+                        " run_ms=" + std::to_string(ms_between(entry.started_at, entry.completed_at));
+    if (entry.deadline != std::chrono::steady_clock::time_point{}) {
+        bool met = entry.status == TaskStatus::COMPLETED && entry.completed_at <= entry.deadline;
+        event += met ? " deadline=MET" : " deadline=MISSED";
+    }
+    return event + "\n";
+}
+
+// Converts a submission time field to a steady_clock point: "+N" is N seconds
+// after submission, a plain number is a Unix timestamp. An empty value leaves
+// the constraint unset; a malformed one returns false.
+bool parse_task_time(const std::string &value, std::chrono::steady_clock::time_point &out) {
+    out = {};
+    if (value.empty()) return true;
+    const char *digits = value.c_str() + (value[0] == '+' ? 1 : 0);
+    char *end = nullptr;
+    errno = 0;
+    long seconds = std::strtol(digits, &end, 10);
+    if (end == digits || *end != '\0' || errno == ERANGE || seconds < 0) return false;
+    auto now = std::chrono::steady_clock::now();
+    if (value[0] == '+') {
+        out = now + std::chrono::seconds(seconds);
+        return true;
+    }
+    auto wall_now = std::chrono::system_clock::now();
+    auto at = std::chrono::system_clock::from_time_t(seconds);
+    out = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(at - wall_now);
+    return true;
+}
+
+size_t ready_count() {
+    return task_queue.size() + deadline_queue.size();
+}
+
+// Ready work is served earliest deadline first; best-effort FIFO tasks run
+// whenever no deadline task is ready. Caller must hold task_mutex.
+const std::string &ready_front() {
+    return !deadline_queue.empty() ? deadline_queue.top().task_id : task_queue.front();
+}
+
+void ready_pop() {
+    if (!deadline_queue.empty()) deadline_queue.pop();
+    else task_queue.pop_front();
+}
+
+// Caller must hold task_mutex. Puts tasks just taken off the ready queues
+// back at their head, in order; deadline tasks re-enter the EDF heap by
+// their deadline.
+void requeue_front(const std::vector<std::string> &batch) {
+    for (auto b = batch.rbegin(); b != batch.rend(); ++b) {
+        const TaskEntry &entry = tasks[*b];
+        if (entry.deadline != std::chrono::steady_clock::time_point{}) {
+            deadline_queue.push(DeadlineItem{entry.deadline, deadline_seq++, *b});
+        } else {
+            task_queue.push_front(*b);
+        }
+    }
+}
+
+// Caller must hold task_mutex. Routes a queued task to the EDF or FIFO ready
+// queue, or parks it on a release timer if its not-before time is ahead.
+// Entries are removed lazily: the scheduler skips anything no longer QUEUED.
+void enqueue_task(const std::string &task_id) {
+    TaskEntry &entry = tasks[task_id];
+    if (entry.not_before > std::chrono::steady_clock::now()) {
+        delayed_releases.emplace(entry.not_before, task_id);
+        timer_cv.notify_one();
+        return;
+    }
+    if (entry.deadline != std::chrono::steady_clock::time_point{}) {
+        deadline_queue.push(DeadlineItem{entry.deadline, deadline_seq++, task_id});
+    } else {
+        task_queue.push_back(task_id);
+    }
+}
+
+// Caller must hold task_mutex. Sends are non-blocking so a slow client can
+// never stall the node handler that reports the completion.
+bool push_event(int sockfd, const std::string &event) {
+    ssize_t sent = send(sockfd, event.c_str(), event.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    return sent == (ssize_t)event.size();
+}
+
+// Blocking send for replies on a connection the calling handler owns: waits
+// for a slow reader (up to its SO_SNDTIMEO) instead of cutting lines off.
+// Must not be called with task_mutex held.
+bool send_reply(int sockfd, const std::string &reply) {
+    size_t offset = 0;
+    while (offset < reply.size()) {
+        ssize_t sent = send(sockfd, reply.c_str() + offset, reply.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        offset += sent;
+    }
+    return true;
+}
+
+// Caller must hold task_mutex.
+void drop_subscriber(int sockfd) {
+    auto s_it = subscribers.find(sockfd);
+    if (s_it == subscribers.end()) return;
+    for (const auto &task_id : s_it->second.pending) {
+        auto w_it = task_watchers.find(task_id);
+        if (w_it == task_watchers.end()) continue;
+        w_it->second.erase(sockfd);
+        if (w_it->second.empty()) task_watchers.erase(w_it);
+    }
+    subscribers.erase(s_it);
+    close(sockfd);
+}
+
+// Caller must hold task_mutex. Pushes one event line to every subscriber
+// watching the task and closes subscribers whose watch set is exhausted.
+void notify_task_event(const std::string &task_id) {
+    auto w_it = task_watchers.find(task_id);
+    if (w_it == task_watchers.end()) return;
+    std::set<int> watchers = std::move(w_it->second);
+    task_watchers.erase(w_it);
+
+    std::string event = completion_event(task_id, tasks[task_id]);
+
+    for (int sockfd : watchers) {
+        auto s_it = subscribers.find(sockfd);
+        if (s_it == subscribers.end()) continue;
+        Subscriber &sub = s_it->second;
+        sub.pending.erase(task_id);
+        if (sub.replaying) {
+            sub.backlog += event;
+            sub.delivered++;
+            continue;
+        }
+        if (!push_event(sockfd, event)) {
+            log("WARN", "Manager: Dropping completion subscriber on socket " + std::to_string(sockfd));
+            drop_subscriber(sockfd);
+            continue;
+        }
+        sub.delivered++;
+        if (sub.pending.empty()) {
+            push_event(sockfd, "ALL_DONE " + std::to_string(sub.delivered) + "\n");
+            drop_subscriber(sockfd);
+        }
+    }
+}
+
+// Completion pushes alone may not notice a vanished client for as long as
+// its tasks run. Every SUBSCRIBER_PROBE_MS, subscribers whose connection was
+// reset are dropped and the rest get a "PENDING <n>" progress line; writing
+// to a client that has gone away provokes the reset seen on the next round.
+// A half-closed socket reads as EOF by design, so EOF alone proves nothing.
+void subscriber_monitor() {
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SUBSCRIBER_PROBE_MS));
+        std::lock_guard<std::mutex> lock(task_mutex);
+        std::vector<pollfd> fds;
+        for (const auto &[sockfd, sub] : subscribers) {
+            if (!sub.replaying) fds.push_back(pollfd{sockfd, 0, 0});
+        }
+        if (fds.empty()) continue;
+        poll(fds.data(), fds.size(), 0);  // POLLHUP and POLLERR are always reported
+        for (const auto &pfd : fds) {
+            bool alive = !(pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) &&
+                         push_event(pfd.fd, "PENDING " + std::to_string(subscribers[pfd.fd].pending.size()) + "\n");
+            if (!alive) {
+                log("WARN", "Manager: Dropping disconnected completion subscriber on socket " + std::to_string(pfd.fd));
+                drop_subscriber(pfd.fd);
+            }
+        }
+    }
+}
+
+// Caller must hold task_mutex. Drops the oldest completed entries once more
+// than MAX_RETAINED_COMPLETED have accumulated, so the tasks map stays bounded.
+void record_completion(const std::string &task_id) {
+    completed_order.push_back(task_id);
+    while (completed_order.size() > MAX_RETAINED_COMPLETED) {
+        auto t_it = tasks.find(completed_order.front());
+        if (t_it != tasks.end() && is_terminal(t_it->second.status)) {
+            tasks.erase(t_it);
+        }
+        completed_order.pop_front();
+    }
+}
+
+// Caller must hold task_mutex. Returns 0 if the client may submit one more
+// task, otherwise the number of milliseconds until a token is available.
+long take_client_token(const std::string &client_ip) {
+    TokenBucket &bucket = client_buckets[client_ip];
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+    bucket.tokens = std::min(CLIENT_BURST, bucket.tokens + elapsed * CLIENT_RATE_PER_SEC);
+    bucket.last_refill = now;
+    if (bucket.tokens >= 1.0) {
+        bucket.tokens -= 1.0;
+        return 0;
+    }
+    return (long)((1.0 - bucket.tokens) / CLIENT_RATE_PER_SEC * 1000.0) + 1;
+}
+
+// Caller must hold task_mutex. Returns an empty string if the task can be
+// admitted, otherwise the REJECTED line to send back to the client.
+// refused_before is how many tasks of the same submission were already
+// rate limited; each gets a later retry slot so a resubmitted batch fits
+// the refilled bucket instead of being refused again. Slots stop at a full
+// refill, since the bucket never holds more than CLIENT_BURST tokens.
+std::string admission_check(const std::string &task_id, const std::string &client_ip, int refused_before) {
+    long lag = scheduler_lag_ms;
+    if (ready_count() + delayed_releases.size() >= MAX_QUEUED_TASKS) {
+        return "REJECTED " + task_id + " QUEUE_FULL retry_after_ms=" + std::to_string(SCHEDULER_TICK_MS * 5 + lag) + "\n";
+    }
+    if (lag > MAX_SCHEDULER_LAG_MS) {
+        return "REJECTED " + task_id + " OVERLOADED retry_after_ms=" + std::to_string(lag * 2) + "\n";
+    }
+    long wait_ms = take_client_token(client_ip);
+    if (wait_ms > 0) {
+        wait_ms = std::min(wait_ms + (long)(refused_before * 1000.0 / CLIENT_RATE_PER_SEC),
+                           (long)(CLIENT_BURST / CLIENT_RATE_PER_SEC * 1000.0));
+        return "REJECTED " + task_id + " RATE_LIMITED retry_after_ms=" + std::to_string(wait_ms) + "\n";
+    }
+    return "";
+}
+
+// Workload names carry a per-task suffix ("Workload_17"); similar tasks
+// share the name with trailing digits and separators stripped.
+std::string workload_class(const std::string &workload) {
+    size_t end = workload.find_last_not_of("0123456789_-");
+    return end == std::string::npos ? workload : workload.substr(0, end + 1);
+}
+
+// Deadline work outranks best-effort work when a node must evict under
+// memory pressure.
+int task_priority(const TaskEntry &entry) {
+    return entry.deadline != std::chrono::steady_clock::time_point{} ? 1 : 0;
+}
+
+// Single-task dispatch line: the task ID, its declared memory and eviction
+// priority, plus " inputs=k1,k2" when the task declares input data so the
+// node can serve it from its cache.
+std::string dispatch_message(const std::string &task_id, const TaskEntry &entry) {
+    std::string msg = task_id + " mem=" + std::to_string(entry.memory_required) + " prio=" + std::to_string(task_priority(entry));
+    for (size_t i = 0; i < entry.inputs.size(); ++i) {
+        msg += (i == 0 ? " inputs=" : ",") + entry.inputs[i];
+    }
+    return msg;
+}
+
+// Caller must hold task_mutex. Memory to charge a node for this task: the
+// declaration scaled by the workload class's high-percentile observed usage,
+// never less than declared / overcommit_ratio and never more than declared.
+// A task declaring no memory reserves none.
+int reservation_for(const TaskEntry &entry) {
+    if (entry.memory_required <= 0) return 0;
+    int floor_mb = (int)(entry.memory_required / overcommit_ratio + 0.5);
+    auto u_it = usage_history.find(workload_class(entry.workload));
+    if (u_it == usage_history.end() || u_it->second.size() < MIN_USAGE_SAMPLES) return entry.memory_required;
+    std::vector<double> ratios(u_it->second.begin(), u_it->second.end());
+    size_t pct = std::min(ratios.size() - 1, (size_t)(ratios.size() * USAGE_PERCENTILE));
+    std::nth_element(ratios.begin(), ratios.begin() + pct, ratios.end());
+    int estimate = (int)(entry.memory_required * ratios[pct] * USAGE_SAFETY_MARGIN + 0.5);
+    return std::clamp(estimate, std::max(1, floor_mb), entry.memory_required);
+}
+
+// Caller must hold node_mutex. A node whose reported RSS is close to its
+// capacity takes no new work, whatever its reservations say.
+bool under_pressure(const NodeInfo &node) {
+    return node.total_memory > 0 && node.rss_memory >= node.total_memory * NODE_PRESSURE_RATIO;
+}
+
+// Caller must hold task_mutex and node_mutex. Batch size adapts to backlog:
+// with a shallow queue tasks go out one at a time for the lowest latency;
+// as the queue deepens past what the nodes can take one by one, up to
+// MAX_BATCH_SIZE small tasks share a dispatch, and scheduler lag past
+// BATCH_LAG_TARGET_MS widens batches further.
+size_t batch_size_limit() {
+    size_t up_nodes = 0;
+    for (const auto &[id, node] : nodes) {
+        if (node.health_status == "UP") up_nodes++;
+    }
+    size_t limit = ready_count() / std::max<size_t>(1, up_nodes * 2);
+    if (scheduler_lag_ms > BATCH_LAG_TARGET_MS) limit *= 2;
+    return std::clamp<size_t>(limit, 1, MAX_BATCH_SIZE);
+}
+
+// Caller must hold task_mutex. Pops the front task plus the run of small
+// tasks behind it that still fit in free_memory, up to limit tasks. A front
+// task above SMALL_TASK_MB always travels alone.
+std::vector<std::string> take_batch(int free_memory, size_t limit) {
+    std::vector<std::string> batch{ready_front()};
+    ready_pop();
+    const TaskEntry &front = tasks[batch.front()];
+    int batch_mem = reservation_for(front);
+    // Tasks with declared inputs are placed individually for locality.
+    if (front.memory_required > SMALL_TASK_MB || !front.inputs.empty()) return batch;
+
+    while (ready_count() > 0 && batch.size() < limit) {
+        auto it = tasks.find(ready_front());
+        if (it == tasks.end() || it->second.status != TaskStatus::QUEUED) {
+            ready_pop();
+            continue;
+        }
+        int mem = reservation_for(it->second);
+        if (it->second.memory_required > SMALL_TASK_MB || !it->second.inputs.empty() || batch_mem + mem > free_memory) break;
+        batch.push_back(ready_front());
+        batch_mem += mem;
+        ready_pop();
+    }
+    return batch;
+}
+
+// Caller must hold task_mutex. Counts the task's deadline as missed; a task
+// is counted once, when its deadline passes or it expires, whichever is first.
+void miss_deadline(TaskEntry &entry) {
+    if (entry.deadline == std::chrono::steady_clock::time_point{} || entry.deadline_missed) return;
+    entry.deadline_missed = true;
+    deadlines_missed++;
+}
+
+// Releases delayed tasks, expires unstarted ones and counts passed deadlines
+// exactly when due, sleeping on timer_cv until the earliest timer instead of
+// polling.
+void timer_loop() {
+    std::unique_lock<std::mutex> lock(task_mutex);
+    while (running) {
+        auto next = std::chrono::steady_clock::time_point::max();
+        if (!delayed_releases.empty()) next = delayed_releases.begin()->first;
+        if (!expiry_timers.empty()) next = std::min(next, expiry_timers.begin()->first);
+        if (!deadline_timers.empty()) next = std::min(next, deadline_timers.begin()->first);
+        if (next == std::chrono::steady_clock::time_point::max()) {
+            timer_cv.wait(lock);
+        } else {
+            timer_cv.wait_until(lock, next);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        while (!delayed_releases.empty() && delayed_releases.begin()->first <= now) {
+            std::string task_id = delayed_releases.begin()->second;
+            delayed_releases.erase(delayed_releases.begin());
+            auto t_it = tasks.find(task_id);
+            if (t_it != tasks.end() && t_it->second.status == TaskStatus::QUEUED) {
+                log("INFO", "Manager: Releasing delayed task " + task_id);
+                enqueue_task(task_id);
+            }
+        }
+        while (!expiry_timers.empty() && expiry_timers.begin()->first <= now) {
+            auto timer = *expiry_timers.begin();
+            expiry_timers.erase(expiry_timers.begin());
+            auto t_it = tasks.find(timer.second);
+            // Only tasks that never started expire; a requeued task keeps running.
+            if (t_it == tasks.end() || t_it->second.status != TaskStatus::QUEUED ||
+                t_it->second.expires_at != timer.first ||
+                t_it->second.assigned_at != std::chrono::steady_clock::time_point{}) {
+                continue;
+            }
+            t_it->second.status = TaskStatus::EXPIRED;
+            t_it->second.completed_at = now;
+            tasks_expired++;
+            miss_deadline(t_it->second);
+            log("WARN", "Manager: Task " + timer.second + " expired before it could start");
+            notify_task_event(timer.second);
+            record_completion(timer.second);
+        }
+        while (!deadline_timers.empty() && deadline_timers.begin()->first <= now) {
+            auto timer = *deadline_timers.begin();
+            deadline_timers.erase(deadline_timers.begin());
+            auto t_it = tasks.find(timer.second);
+            if (t_it == tasks.end() || is_terminal(t_it->second.status) || t_it->second.deadline != timer.first) {
+                continue;
+            }
+            miss_deadline(t_it->second);
+            log("WARN", "Manager: Task " + timer.second + " passed its deadline while " +
+                        status_name(t_it->second.status));
+        }
+    }
+}
+
+// Caller must hold task_mutex. Run time past which a task of this class is a
+// straggler, or -1 while there are too few samples to tell.
+long straggler_threshold_ms(const std::string &workload) {
+    auto h_it = runtime_history.find(workload_class(workload));
+    if (h_it == runtime_history.end() || h_it->second.size() < MIN_RUNTIME_SAMPLES) return -1;
+    std::vector<long> samples(h_it->second.begin(), h_it->second.end());
+    size_t p90 = samples.size() * 9 / 10;
+    std::nth_element(samples.begin(), samples.begin() + p90, samples.end());
+    return std::max(MIN_SPECULATION_MS, (long)(samples[p90] * STRAGGLER_FACTOR));
+}
+
+// Caller must hold task_mutex and node_mutex. Launches one speculative copy
+// of each clear straggler on another live node with spare memory.
+void speculate_stragglers() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto &[task_id, entry] : tasks) {
+        if (entry.status != TaskStatus::ASSIGNED || !entry.speculative_node.empty()) continue;
+        long threshold = straggler_threshold_ms(entry.workload);
+        long running_ms = ms_between(entry.started_at, now);
+        if (threshold < 0 || running_ms <= threshold) continue;
+
+        for (auto &[id, node] : nodes) {
+            if (id == entry.assigned_node || node.health_status != "UP" || under_pressure(node) ||
+                node.available_memory < entry.reserved_memory) {
+                continue;
+            }
+            if (!send_to_node(node, dispatch_message(task_id, entry))) continue;
+
+            node.available_memory -= entry.reserved_memory;
+            entry.speculative_node = id;
+            entry.speculated_at = now;
+            speculations_launched++;
+            log("WARN", "Manager: Task " + task_id + " on " + entry.assigned_node + " is a straggler (" +
+                        std::to_string(running_ms) + " ms > " + std::to_string(threshold) +
+                        " ms), speculating on " + id);
+            break;
+        }
+    }
+}
+
+// Caller must hold task_mutex. Handles the loss of node_id for a running
+// task: a lost speculative copy is forgotten and a lost primary hands over
+// to its speculative copy. Returns true if no copy is left to finish it.
+bool lose_task_copy(TaskEntry &entry, const std::string &node_id) {
+    if (entry.status != TaskStatus::ASSIGNED) return false;
+    if (entry.speculative_node == node_id) {
+        entry.speculative_node.clear();
+        return false;
+    }
+    if (entry.assigned_node != node_id) return false;
+    if (!entry.speculative_node.empty()) {
+        entry.assigned_node = entry.speculative_node;
+        entry.started_at = entry.speculated_at;
+        entry.speculative_node.clear();
+        return false;
+    }
+    return true;
+}
+
+// Caller must hold node_mutex. Number of the task's inputs a node reports
+// as cached (subject to Bloom filter false positives).
+int warm_inputs(const NodeInfo &node, const TaskEntry &entry) {
+    int warm = 0;
+    for (const auto &key : entry.inputs) {
+        if (node.input_cache.might_contain(key)) warm++;
+    }
+    return warm;
+}
+
+// Caller must hold task_mutex and node_mutex. Nodes with room for the
+// task's reservation and no memory pressure, warmest first;
+// among equally warm nodes the map order is kept.
+std::vector<std::string> placement_order(const TaskEntry &entry) {
+    std::vector<std::pair<int, std::string>> ranked;
+    int reservation = reservation_for(entry);
+    for (const auto &[id, node] : nodes) {
+        if (node.health_status == "UP" && node.available_memory >= reservation && !under_pressure(node)) {
+            ranked.push_back({warm_inputs(node, entry), id});
+        }
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::vector<std::string> order;
+    for (const auto &candidate : ranked) order.push_back(candidate.second);
+    return order;
+}
+
+// Caller must hold task_mutex and node_mutex. Delay scheduling: a task whose
+// inputs are warm only on nodes that are currently full is held back for up
+// to LOCALITY_WAIT_MS before it is placed cold.
+bool wait_for_locality(TaskEntry &entry, const std::vector<std::string> &order) {
+    if (entry.inputs.empty()) return false;
+    if (!order.empty() && warm_inputs(nodes[order.front()], entry) > 0) return false;
+
+    bool warm_elsewhere = false;
+    for (const auto &[id, node] : nodes) {
+        if (node.health_status == "UP" && warm_inputs(node, entry) > 0) warm_elsewhere = true;
+    }
+    if (!warm_elsewhere) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if (entry.locality_wait_since == std::chrono::steady_clock::time_point{}) entry.locality_wait_since = now;
+    return ms_between(entry.locality_wait_since, now) < LOCALITY_WAIT_MS;
+}
+
 void assign_tasks() {
+    bool overloaded = false;
     while (running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto tick_start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(SCHEDULER_TICK_MS));
 
         std::lock_guard<std::mutex> lock(task_mutex);
-        while (!task_queue.empty()) {
+        // Scheduler lag: how far this pass started behind its tick, measured
+        // once the task lock is held so lock contention counts too.
+        long lag = ms_between(tick_start, std::chrono::steady_clock::now()) - SCHEDULER_TICK_MS;
+        scheduler_lag_ms = std::max(0L, lag);
+        if ((lag > MAX_SCHEDULER_LAG_MS) != overloaded) {
+            overloaded = !overloaded;
+            log(overloaded ? "WARN" : "INFO", std::string("Manager: Scheduler ") + (overloaded ? "overloaded" : "recovered") +
+                                              " (lag " + std::to_string(std::max(0L, lag)) + " ms, queue depth " +
+                                              std::to_string(ready_count()) + ")");
+        }
+        // Tasks waiting for a warm node this pass, kept in queue order so they
+        // go back to the head of the queue rather than behind newer work.
+        std::vector<std::string> deferred;
+        std::vector<DeadlineItem> deferred_edf;
+        while (ready_count() > 0) {
             std::lock_guard<std::mutex> nlock(node_mutex);
             bool assigned = false;
 
-            std::string task = task_queue.front();
+            std::string task = ready_front();
             auto it = tasks.find(task);
-            if (it != tasks.end() && it->second.status == TaskStatus::COMPLETED) {
-                log("INFO", "Skipping already completed task " + task);
-                task_queue.pop();
+            if (it == tasks.end() || it->second.status != TaskStatus::QUEUED) {
+                // Stale entry: completed, expired or already dispatched.
+                ready_pop();
                 continue;
             }
 
             int mem_needed = it->second.memory_required;
-            for (auto &[id, node] : nodes) {
-                if (node.available_memory >= mem_needed) {
-                    sockaddr_in node_addr{};
-                    node_addr.sin_family = AF_INET;
-                    node_addr.sin_port = htons(node.port);
-                    inet_pton(AF_INET, node.ip.c_str(), &node_addr.sin_addr);
-
-                    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-                    if (sockfd < 0 || connect(sockfd, (sockaddr *)&node_addr, sizeof(node_addr)) < 0) {
-                        log("ERROR", "Manager: Failed to connect to node " + id + " at port " + std::to_string(node.port));
-                        continue;
-                    }
+            std::vector<std::string> order = placement_order(it->second);
+            if (wait_for_locality(it->second, order)) {
+                if (!deadline_queue.empty()) deferred_edf.push_back(deadline_queue.top());
+                else deferred.push_back(task);
+                ready_pop();
+                continue;
+            }
+
+            for (const auto &id : order) {
+                NodeInfo &node = nodes[id];
+                int sockfd = open_channel(node);
+                if (sockfd < 0) {
+                    log("ERROR", "Manager: Failed to connect to node " + id + " at port " + std::to_string(node.port));
+                    continue;
+                }
 
-                    send(sockfd, task.c_str(), task.size(), 0);
-                    close(sockfd);
+                std::vector<std::string> batch = take_batch(node.available_memory, batch_size_limit());
+                std::string msg = batch.size() == 1 ? dispatch_message(task, it->second) : "BATCH";
+                if (batch.size() > 1) {
+                    for (const auto &batch_task : batch) {
+                        const TaskEntry &entry = tasks[batch_task];
+                        msg += " " + batch_task + ":" + std::to_string(entry.memory_required) + ":" +
+                               std::to_string(task_priority(entry));
+                    }
+                }
+                // Task state only changes once the node has the message; a
+                // failed dispatch puts the batch back for the next node.
+                if (!send_on_channel(node, sockfd, msg)) {
+                    log("ERROR", "Manager: Failed to dispatch to node " + id + ", trying the next node");
+                    requeue_front(batch);
+                    continue;
+                }
 
-                    log("INFO", "Assigned " + task + " to " + id + " at port " + std::to_string(node.port) + " (" + std::to_string(mem_needed) + " MB)");
+                int batch_mem = 0;
+                auto now = std::chrono::steady_clock::now();
+                for (const auto &batch_task : batch) {
+                    TaskEntry &entry = tasks[batch_task];
+                    entry.status = TaskStatus::ASSIGNED;
+                    entry.assigned_node = id;
+                    entry.assigned_at = now;
+                    entry.started_at = now;
+                    entry.reserved_memory = reservation_for(entry);
+                    batch_mem += entry.reserved_memory;
+                }
+                node.available_memory -= batch_mem;
+                if (!it->second.inputs.empty()) {
+                    if (warm_inputs(node, it->second) > 0) locality_hits++;
+                    else locality_misses++;
+                }
 
-                    tasks[task].status = TaskStatus::ASSIGNED;
-                    tasks[task].assigned_node = id;
-                    node.available_memory -= mem_needed;
-                    task_queue.pop();
-                    assigned = true;
-                    break;
+                if (batch.size() == 1) {
+                    std::string reserved = batch_mem == mem_needed ? "" : ", reserved " + std::to_string(batch_mem) + " MB";
+                    log("INFO", "Assigned " + task + " to " + id + " at port " + std::to_string(node.port) + " (" + std::to_string(mem_needed) + " MB" + reserved + ")");
+                } else {
+                    log("INFO", "Assigned batch of " + std::to_string(batch.size()) + " tasks (" + batch.front() + " .. " +
+                                batch.back() + ") to " + id + " at port " + std::to_string(node.port) + " (" +
+                                std::to_string(batch_mem) + " MB)");
                 }
+                assigned = true;
+                break;
             }
 
             if (!assigned) break;
         }
+        for (auto d = deferred.rbegin(); d != deferred.rend(); ++d) task_queue.push_front(*d);
+        for (const auto &item : deferred_edf) deadline_queue.push(item);  // original seq keeps their place
+
+        std::lock_guard<std::mutex> nlock(node_mutex);
+        speculate_stragglers();
     }
 }
 
@@ -154,21 +936,33 @@ void health_monitor() {
     while (running) {
         std::this_thread::sleep_for(std::chrono::seconds(10));
         std::vector<std::string> down_nodes;
+        // Probe a snapshot without node_mutex so a slow node cannot stall
+        // dispatch, completions or the status port.
+        std::vector<NodeInfo> snapshot;
         {
             std::lock_guard<std::mutex> lock(node_mutex);
-            for (auto &[id, node] : nodes) {
-                sockaddr_in node_addr{};
-                node_addr.sin_family = AF_INET;
-                node_addr.sin_port = htons(node.port);
-                inet_pton(AF_INET, node.ip.c_str(), &node_addr.sin_addr);
-                int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-                bool alive = false;
-                if (sockfd >= 0 && connect(sockfd, (sockaddr *)&node_addr, sizeof(node_addr)) == 0) {
-                    alive = true;
-                    close(sockfd);
-                }
-                node.health_status = alive ? "UP" : "DOWN";
-                if (!alive) {
+            for (const auto &[id, node] : nodes) snapshot.push_back(node);
+        }
+        // A stopped process still completes connects into its accept
+        // backlog, so a node must also have reported recently.
+        std::map<std::string, bool> alive;
+        auto now = std::chrono::steady_clock::now();
+        for (const auto &node : snapshot) {
+            if (ms_between(node.last_heard, now) > NODE_SILENCE_MS) {
+                alive[node.id] = false;
+                continue;
+            }
+            int sockfd = connect_to_node(node);
+            alive[node.id] = sockfd >= 0;
+            if (sockfd >= 0) close(sockfd);
+        }
+        {
+            std::lock_guard<std::mutex> lock(node_mutex);
+            for (const auto &[id, up] : alive) {
+                auto n_it = nodes.find(id);
+                if (n_it == nodes.end()) continue;  // disconnected meanwhile
+                n_it->second.health_status = up ? "UP" : "DOWN";
+                if (!up) {
                     down_nodes.push_back(id);
                 }
             }
@@ -179,10 +973,10 @@ void health_monitor() {
                 // Requeue unfinished tasks
                 std::lock_guard<std::mutex> lock(task_mutex);
                 for (auto &[task_id, entry] : tasks) {
-                    if (entry.assigned_node == id && entry.status != TaskStatus::COMPLETED) {
+                    if (lose_task_copy(entry, id)) {
                         entry.status = TaskStatus::QUEUED;
                         entry.assigned_node.clear();
-                        task_queue.push(task_id);
+                        enqueue_task(task_id);
                     }
                 }
                 // Remove node from nodes map
@@ -200,6 +994,66 @@ void health_monitor() {
     }
 }
 
+// Caller must hold task_mutex; node_mutex is taken here, in the same order
+// as the scheduler. Marks a task completed, returns its memory to the node
+// and notifies subscribers. Returns false for unknown or already completed
+// tasks so duplicate acknowledgements are harmless.
+bool complete_task(const std::string &task, const std::string &node_id) {
+    auto t_it = tasks.find(task);
+    if (t_it == tasks.end() || is_terminal(t_it->second.status)) return false;
+    std::lock_guard<std::mutex> nlock(node_mutex);
+    TaskEntry &entry = t_it->second;
+    entry.status = TaskStatus::COMPLETED;
+    entry.completed_at = std::chrono::steady_clock::now();
+
+    auto &history = runtime_history[workload_class(entry.workload)];
+    if (node_id == entry.speculative_node) entry.started_at = entry.speculated_at;
+    history.push_back(ms_between(entry.started_at, entry.completed_at));
+    if (history.size() > RUNTIME_HISTORY) history.pop_front();
+
+    // First finisher wins; the other copy gets its memory credit back and
+    // is cancelled. Its late TASK_DONE, if any, is ignored above.
+    if (!entry.speculative_node.empty()) {
+        std::string loser = node_id == entry.speculative_node ? entry.assigned_node : entry.speculative_node;
+        if (node_id == entry.speculative_node) speculations_won++;
+        entry.assigned_node = node_id;
+        entry.speculative_node.clear();
+        auto l_it = nodes.find(loser);
+        if (l_it != nodes.end()) {
+            l_it->second.available_memory += entry.reserved_memory;
+            send_to_node(l_it->second, "CANCEL " + task);
+        }
+        log("INFO", "Manager: Task " + task + " finished first on " + node_id + ", cancelled copy on " + loser);
+    }
+    if (entry.deadline != std::chrono::steady_clock::time_point{}) {
+        if (entry.completed_at <= entry.deadline) {
+            deadlines_met++;
+        } else {
+            miss_deadline(entry);
+            log("WARN", "Manager: Task " + task + " missed its deadline by " +
+                        std::to_string(ms_between(entry.deadline, entry.completed_at)) + " ms");
+        }
+    }
+    // Restore memory to node
+    auto n_it = nodes.find(node_id);
+    if (n_it != nodes.end()) {
+        n_it->second.available_memory += entry.reserved_memory;
+    }
+    notify_task_event(task);
+    record_completion(task);
+    return true;
+}
+
+// Caller must hold task_mutex. Feeds one observed usage sample into the
+// task's workload class; reservations for that class follow from it.
+void record_usage(const std::string &task, int used_mb) {
+    auto t_it = tasks.find(task);
+    if (t_it == tasks.end() || t_it->second.memory_required <= 0 || used_mb <= 0) return;
+    auto &history = usage_history[workload_class(t_it->second.workload)];
+    history.push_back((double)used_mb / t_it->second.memory_required);
+    if (history.size() > USAGE_HISTORY) history.pop_front();
+}
+
 void handle_node(int client_sock) {
     char buffer[1024] = {0};
     read(client_sock, buffer, sizeof(buffer));
@@ -208,111 +1062,379 @@ void handle_node(int client_sock) {
     int port;
     int available_memory = 0;
     iss >> command >> node_id >> port >> available_memory;
+    // Optional "LOCAL <path>": the node also serves tasks on a Unix socket.
+    std::string transport, path;
+    iss >> transport >> path;
 
-    sockaddr_in addr;
-    socklen_t len = sizeof(addr);
-    getpeername(client_sock, (sockaddr *)&addr, &len);
-    std::string ip = inet_ntoa(addr.sin_addr);
+    std::string ip = peer_ip(client_sock);
 
     if (command == "REGISTER") {
         NodeInfo node{node_id, ip, port, client_sock, available_memory};
+        node.total_memory = available_memory;
+        // Only trust the Unix socket if the node really shares our host.
+        if (transport == "LOCAL" && !path.empty() && ip.rfind("127.", 0) == 0) {
+            node.local_path = path;
+        }
         {
             std::lock_guard<std::mutex> lock(node_mutex);
+            auto n_it = nodes.find(node_id);
+            if (n_it != nodes.end()) close_channel(n_it->second);  // re-registration
             nodes[node_id] = node;
         }
-        log("INFO", "Node " + node_id + " connected from " + ip + ":" + std::to_string(port) + " with " + std::to_string(available_memory) + " MB memory");
+        log("INFO", "Node " + node_id + " connected from " + ip + ":" + std::to_string(port) + " with " + std::to_string(available_memory) + " MB memory" +
+                    (node.local_path.empty() ? "" : " (local socket " + node.local_path + ")"));
         log("INFO", "Manager: handling persistent connection for node " + node_id +
                     " (socket: " + std::to_string(client_sock) + ") to persistent handler.");
     }
 
-    char recv_buf[1024];
+    char recv_buf[4096];
+    std::string pending;  // partial line carried over between reads
+    pollfd pfd{client_sock, POLLIN, 0};
     while (running) {
-        ssize_t len = recv(client_sock, recv_buf, sizeof(recv_buf) - 1, MSG_DONTWAIT);
+        // Block until the node sends something or hangs up.
+        int ready = poll(&pfd, 1, NODE_POLL_TIMEOUT_MS);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) continue;
+        ssize_t len = ready < 0 ? -1 : recv(client_sock, recv_buf, sizeof(recv_buf), 0);
         if (len > 0) {
-            recv_buf[len] = '\0';
-            std::string msg(recv_buf);
-            std::istringstream stream(msg);
-            std::string line;
-            while (std::getline(stream, line)) {
+            {
+                std::lock_guard<std::mutex> nlock(node_mutex);
+                auto n_it = nodes.find(node_id);
+                if (n_it != nodes.end()) n_it->second.last_heard = std::chrono::steady_clock::now();
+            }
+            pending.append(recv_buf, len);
+            size_t pos;
+            while ((pos = pending.find('\n')) != std::string::npos) {
+                std::string line = pending.substr(0, pos);
+                pending.erase(0, pos + 1);
                 if (line.rfind("TASK_DONE ", 0) == 0) {
                     std::string task = line.substr(10);
                     std::lock_guard<std::mutex> lock(task_mutex);
-                    auto &entry = tasks[task];
-                    entry.status = TaskStatus::COMPLETED;
-                    // Restore memory to node
+                    if (complete_task(task, node_id)) {
+                        log("INFO", "Manager: Task " + task + " marked as completed by " + node_id);
+                    }
+                } else if (line.rfind("TASK_USAGE ", 0) == 0) {
+                    // Observed peak memory of one task: "TASK_USAGE <task> <MB>".
+                    std::istringstream fields(line.substr(11));
+                    std::string task;
+                    int used_mb = 0;
+                    fields >> task >> used_mb;
+                    std::lock_guard<std::mutex> lock(task_mutex);
+                    record_usage(task, used_mb);
+                } else if (line.rfind("TASKS_USAGE ", 0) == 0) {
+                    // Batched form: "TASKS_USAGE <task>:<MB> ...".
+                    std::istringstream fields(line.substr(12));
+                    std::string item;
+                    std::lock_guard<std::mutex> lock(task_mutex);
+                    while (fields >> item) {
+                        size_t colon = item.rfind(':');
+                        if (colon == std::string::npos) continue;
+                        record_usage(item.substr(0, colon), std::atoi(item.c_str() + colon + 1));
+                    }
+                } else if (line.rfind("NODE_USAGE ", 0) == 0) {
+                    std::lock_guard<std::mutex> nlock(node_mutex);
                     auto n_it = nodes.find(node_id);
-                    if (n_it != nodes.end()) {
-                        n_it->second.available_memory += entry.memory_required;
+                    if (n_it != nodes.end()) n_it->second.rss_memory = std::atoi(line.c_str() + 11);
+                } else if (line.rfind("TASK_EVICTED ", 0) == 0) {
+                    std::string task = line.substr(13);
+                    std::lock_guard<std::mutex> lock(task_mutex);
+                    auto t_it = tasks.find(task);
+                    // Stale reports from a node that no longer holds the task are ignored.
+                    if (t_it != tasks.end() && t_it->second.status == TaskStatus::ASSIGNED &&
+                        (t_it->second.assigned_node == node_id || t_it->second.speculative_node == node_id)) {
+                        TaskEntry &entry = t_it->second;
+                        {
+                            std::lock_guard<std::mutex> nlock(node_mutex);
+                            auto n_it = nodes.find(node_id);
+                            if (n_it != nodes.end()) n_it->second.available_memory += entry.reserved_memory;
+                        }
+                        tasks_evicted++;
+                        if (lose_task_copy(entry, node_id)) {
+                            entry.status = TaskStatus::QUEUED;
+                            entry.assigned_node.clear();
+                            enqueue_task(task);
+                            log("WARN", "Manager: Task " + task + " evicted by " + node_id + " under memory pressure, requeued");
+                        } else {
+                            log("WARN", "Manager: Task " + task + " evicted by " + node_id + " under memory pressure, copy on " +
+                                        entry.assigned_node + " continues");
+                        }
+                    }
+                } else if (line.rfind("CACHE ", 0) == 0) {
+                    // Bloom filter of the node's cached input keys.
+                    std::lock_guard<std::mutex> nlock(node_mutex);
+                    auto n_it = nodes.find(node_id);
+                    if (n_it != nodes.end()) n_it->second.input_cache = BloomFilter::from_hex(line.substr(6));
+                } else if (line.rfind("TASKS_DONE ", 0) == 0) {
+                    // Batched acknowledgement: one line, one lock, one log entry.
+                    std::istringstream ids(line.substr(11));
+                    std::string task;
+                    int completed = 0;
+                    std::lock_guard<std::mutex> lock(task_mutex);
+                    while (ids >> task) {
+                        if (complete_task(task, node_id)) completed++;
                     }
-                    log("INFO", "Manager: Task " + task + " marked as completed by " + node_id);
+                    log("INFO", "Manager: Batch of " + std::to_string(completed) + " tasks marked as completed by " + node_id);
                 }
             }
-        } else {
-            char ping[1];
-            ssize_t res = recv(client_sock, ping, sizeof(ping), MSG_PEEK);
-            if (res == 0) {
-                log("WARN", "Node " + node_id + " disconnected unexpectedly.");
+        } else if (len == 0 || errno != EINTR) {
+            log("WARN", "Node " + node_id + " disconnected unexpectedly.");
 
-                std::lock_guard<std::mutex> lock(task_mutex);
-                for (auto &[task_id, entry] : tasks) {
-                    if (entry.assigned_node == node_id && entry.status != TaskStatus::COMPLETED) {
-                        log("INFO", "Reassigning task " + task_id + " from failed node " + node_id);
-                        entry.status = TaskStatus::QUEUED;
-                        entry.assigned_node.clear();
-                        task_queue.push(task_id);
-                        // Restore memory to node (if node comes back)
-                        auto n_it = nodes.find(node_id);
-                        if (n_it != nodes.end()) {
-                            n_it->second.available_memory += entry.memory_required;
-                        }
+            std::lock_guard<std::mutex> lock(task_mutex);
+            for (auto &[task_id, entry] : tasks) {
+                if (lose_task_copy(entry, node_id)) {
+                    log("INFO", "Reassigning task " + task_id + " from failed node " + node_id);
+                    entry.status = TaskStatus::QUEUED;
+                    entry.assigned_node.clear();
+                    enqueue_task(task_id);
+                    // Restore memory to node (if node comes back)
+                    auto n_it = nodes.find(node_id);
+                    if (n_it != nodes.end()) {
+                        n_it->second.available_memory += entry.reserved_memory;
                     }
                 }
+            }
 
-                {
-                    std::lock_guard<std::mutex> nlock(node_mutex);
-                    nodes.erase(node_id);
-                }
-
-                close(client_sock);
-                return;
+            {
+                std::lock_guard<std::mutex> nlock(node_mutex);
+                auto n_it = nodes.find(node_id);
+                if (n_it != nodes.end()) close_channel(n_it->second);
+                nodes.erase(node_id);
             }
-        }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            close(client_sock);
+            return;
+        }
     }
 
     close(client_sock);
 }
 
+// Writes a new subscriber's replay from its own handler thread, then any
+// events queued meanwhile, before completion pushes take over the socket.
+// A client that stops reading loses its subscription.
+void finish_replay(int sockfd, std::string replay) {
+    while (true) {
+        if (!replay.empty() && !send_reply(sockfd, replay)) {
+            std::lock_guard<std::mutex> lock(task_mutex);
+            log("WARN", "Manager: Dropping completion subscriber on socket " + std::to_string(sockfd) +
+                        ", replay not delivered");
+            drop_subscriber(sockfd);
+            return;
+        }
+        std::string all_done;
+        {
+            std::lock_guard<std::mutex> lock(task_mutex);
+            Subscriber &sub = subscribers[sockfd];
+            replay = std::move(sub.backlog);
+            sub.backlog.clear();
+            if (!replay.empty()) continue;
+            sub.replaying = false;
+            if (!sub.pending.empty()) return;
+            // Everything finished while the replay was being written.
+            all_done = "ALL_DONE " + std::to_string(sub.delivered) + "\n";
+            subscribers.erase(sockfd);
+        }
+        send_reply(sockfd, all_done);
+        close(sockfd);
+        return;
+    }
+}
+
+// Client protocol: one task per line (task_id:workload:memory:dependencies),
+// optionally followed by timing fields "start=<t>:deadline=<t>:expire=<t>"
+// in any order, where <t> is "+<seconds>" from now or a Unix timestamp, and
+// "inputs=<key>,<key>" naming input data the task reads.
+// Two optional control lines turn the connection into a completion stream:
+//   WAIT              - push completion events for the tasks in this submission
+//   WATCH <id> [...]  - push completion events for already submitted tasks
+// Each task line is subject to admission control (bounded queue, scheduler
+// lag, per-client token bucket); refused tasks are answered with
+// "REJECTED <task> <reason> retry_after_ms=<n>" and are never enqueued.
+// A line whose start/deadline/expire value does not parse is answered with
+// "REJECTED <task> BAD_TIMING" and no retry hint: resubmitting cannot help.
+// The client half-closes its write side; the manager then streams
+// "DONE <task> <COMPLETED|EXPIRED> <node|-> wait_ms=<n> run_ms=<n>" lines,
+// with " deadline=MET|MISSED" appended for tasks that have a deadline, and
+// "UNKNOWN <task>" for watched IDs it has never seen, followed by
+// "ALL_DONE <count>" before closing. "PENDING <n>" lines report progress in
+// between. With MAX_SUBSCRIBERS streams already open, the whole connection
+// is refused with "BUSY retry_after_ms=<n>" before any line is processed.
+// Without either control line the connection is closed right after
+// submission, as before.
 void handle_client(int client_sock) {
-    char buffer[1024] = {0};
-    ssize_t valread = read(client_sock, buffer, sizeof(buffer));
-    std::string task_input(buffer, valread);
+    std::string client_ip = peer_ip(client_sock);
+
+    // A client that never finishes sending must not pin a handler forever.
+    timeval tv{CLIENT_RECV_TIMEOUT_SEC, 0};
+    setsockopt(client_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    timeval send_tv{CLIENT_SEND_TIMEOUT_SEC, 0};
+    setsockopt(client_sock, SOL_SOCKET, SO_SNDTIMEO, &send_tv, sizeof(send_tv));
+
+    std::string task_input;
+    char buffer[1024];
+    ssize_t valread;
+    while ((valread = read(client_sock, buffer, sizeof(buffer))) > 0) {
+        task_input.append(buffer, valread);
+    }
     std::istringstream iss(task_input);
     std::string line;
+    bool wants_stream = false;
+    while (std::getline(iss, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line == "WAIT" || line.rfind("WATCH ", 0) == 0) wants_stream = true;
+    }
+    iss.clear();
+    iss.seekg(0);
+    if (wants_stream) {
+        size_t open_streams;
+        {
+            std::lock_guard<std::mutex> lock(task_mutex);
+            open_streams = subscribers.size();
+        }
+        if (open_streams >= MAX_SUBSCRIBERS) {
+            log("WARN", "Manager: Refusing completion stream from " + client_ip + ", " +
+                        std::to_string(open_streams) + " subscribers open");
+            send_reply(client_sock, "BUSY retry_after_ms=" + std::to_string(SUBSCRIBER_PROBE_MS) + "\n");
+            close(client_sock);
+            return;
+        }
+    }
+    bool wait_submitted = false;
+    std::vector<std::string> submitted;
+    std::set<std::string> watched;
+    int rejected = 0;
+    std::string replies;  // sent by this thread once task_mutex is released
+    bool streaming = false;
     {
         std::lock_guard<std::mutex> lock(task_mutex);
         while (std::getline(iss, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
             if (line.empty()) continue;
+            if (line == "WAIT") {
+                wait_submitted = true;
+                continue;
+            }
+            if (line.rfind("WATCH ", 0) == 0) {
+                std::istringstream wss(line.substr(6));
+                std::string task_id;
+                while (wss >> task_id) watched.insert(task_id);
+                continue;
+            }
             // Parse task string: task_id:workload:memory:dependencies
             std::istringstream lss(line);
             std::string task_id, workload, memory_str, deps_str;
             std::getline(lss, task_id, ':');
             std::getline(lss, workload, ':');
             std::getline(lss, memory_str, ':');
-            std::getline(lss, deps_str, ':');
+            // Options follow the dependency field, or the memory field when
+            // the dependency field is left out.
+            std::string field, start_str, deadline_str, expire_str, inputs_str;
+            for (bool first = true; std::getline(lss, field, ':'); first = false) {
+                if (field.rfind("inputs=", 0) == 0) inputs_str = field.substr(7);
+                else if (field.rfind("start=", 0) == 0) start_str = field.substr(6);
+                else if (field.rfind("deadline=", 0) == 0) deadline_str = field.substr(9);
+                else if (field.rfind("expire=", 0) == 0) expire_str = field.substr(7);
+                else if (first) deps_str = field;
+                else log("WARN", "Manager: Ignoring unknown field '" + field + "' of task " + task_id);
+            }
+            // A task with a timing field that does not parse is refused rather
+            // than run as best-effort work outside the deadline statistics.
+            std::chrono::steady_clock::time_point not_before, deadline, expires_at;
+            if (!parse_task_time(start_str, not_before) || !parse_task_time(deadline_str, deadline) ||
+                !parse_task_time(expire_str, expires_at)) {
+                log("WARN", "Manager: Rejecting task " + task_id + " with malformed timing field");
+                replies += "REJECTED " + task_id + " BAD_TIMING\n";
+                continue;
+            }
             int memory = memory_str.empty() ? 128 : std::stoi(memory_str);
             std::vector<std::string> deps;
             // For prototype, dependencies are empty
-            if (tasks.find(task_id) != tasks.end() && tasks[task_id].status == TaskStatus::COMPLETED) {
-                log("INFO", "Ignoring already completed task: " + task_id);
+            // A known task is only replaced once it has expired. Queued or
+            // running ones keep their entry, including the node reservation.
+            auto existing = tasks.find(task_id);
+            if (existing != tasks.end() && existing->second.status != TaskStatus::EXPIRED) {
+                log("INFO", "Ignoring resubmitted task " + task_id + " (" + status_name(existing->second.status) + ")");
+                submitted.push_back(task_id);
                 continue;
             }
+            std::string rejection = admission_check(task_id, client_ip, rejected);
+            if (!rejection.empty()) {
+                replies += rejection;
+                rejected++;
+                continue;
+            }
+            submitted.push_back(task_id);
             tasks[task_id] = TaskEntry{task_id, TaskStatus::QUEUED, "", memory, deps};
-            task_queue.push(task_id);
-            log("INFO", "Received task: " + task_id + " (" + std::to_string(memory) + " MB)");
+            TaskEntry &entry = tasks[task_id];
+            entry.workload = workload;
+            std::istringstream inputs_ss(inputs_str);
+            std::string key;
+            while (std::getline(inputs_ss, key, ',')) {
+                if (!key.empty()) entry.inputs.push_back(key);
+            }
+            entry.submitted_at = std::chrono::steady_clock::now();
+            entry.not_before = not_before;
+            entry.deadline = deadline;
+            entry.expires_at = expires_at;
+            if (entry.expires_at != std::chrono::steady_clock::time_point{}) {
+                expiry_timers.emplace(entry.expires_at, task_id);
+                timer_cv.notify_one();
+            }
+            if (entry.deadline != std::chrono::steady_clock::time_point{}) {
+                deadline_timers.emplace(entry.deadline, task_id);
+                timer_cv.notify_one();
+            }
+            enqueue_task(task_id);
+            std::string timing;
+            if (!start_str.empty()) timing += " start=" + start_str;
+            if (!deadline_str.empty()) timing += " deadline=" + deadline_str;
+            if (!expire_str.empty()) timing += " expire=" + expire_str;
+            if (!inputs_str.empty()) timing += " inputs=" + inputs_str;
+            log("INFO", "Received task: " + task_id + " (" + std::to_string(memory) + " MB)" + timing);
+        }
+
+        if (rejected > 0) {
+            log("WARN", "Manager: Rejected " + std::to_string(rejected) + " task(s) from " + client_ip +
+                        " (queue depth " + std::to_string(ready_count()) + ", scheduler lag " +
+                        std::to_string(scheduler_lag_ms) + " ms)");
+        }
+
+        if (wait_submitted) watched.insert(submitted.begin(), submitted.end());
+        if (wait_submitted || !watched.empty()) {
+            // Registered under the same lock as the enqueue, so no completion
+            // can slip in between submission and subscription. Unknown and
+            // already finished tasks are replayed after the REJECTED lines.
+            Subscriber sub{client_sock, {}, 0};
+            for (const auto &task_id : watched) {
+                auto t_it = tasks.find(task_id);
+                if (t_it == tasks.end()) {
+                    replies += "UNKNOWN " + task_id + "\n";
+                } else if (is_terminal(t_it->second.status)) {
+                    replies += completion_event(task_id, t_it->second);
+                    sub.delivered++;
+                } else {
+                    sub.pending.insert(task_id);
+                    task_watchers[task_id].insert(client_sock);
+                }
+            }
+            if (sub.pending.empty()) {
+                replies += "ALL_DONE " + std::to_string(sub.delivered) + "\n";
+            } else {
+                sub.replaying = true;
+                subscribers[client_sock] = sub;
+                streaming = true;
+                log("INFO", "Manager: Client on socket " + std::to_string(client_sock) + " waiting on " +
+                            std::to_string(sub.pending.size()) + " task(s)");
+            }
         }
     }
+    if (streaming) {
+        // Socket ownership moves to the subscriber registry.
+        finish_replay(client_sock, replies);
+        return;
+    }
+    if (!replies.empty() && !send_reply(client_sock, replies)) {
+        log("WARN", "Manager: Could not deliver replies to " + client_ip);
+    }
     close(client_sock);
 }
 
@@ -345,8 +1467,17 @@ void status_server() {
             std::lock_guard<std::mutex> lock(task_mutex);
             oss << "TASKS\n";
             for (const auto &[tid, entry] : tasks) {
-                oss << tid << "," << (entry.status == TaskStatus::QUEUED ? "QUEUED" : entry.status == TaskStatus::ASSIGNED ? "ASSIGNED" : "COMPLETED") << "," << entry.assigned_node << "," << entry.memory_required << "\n";
+                oss << tid << "," << status_name(entry.status) << "," << entry.assigned_node << "," << entry.memory_required << "\n";
             }
+            oss << "STATS\n";
+            oss << "deadlines_met," << deadlines_met << "\n";
+            oss << "deadlines_missed," << deadlines_missed << "\n";
+            oss << "tasks_expired," << tasks_expired << "\n";
+            oss << "speculations_launched," << speculations_launched << "\n";
+            oss << "speculations_won," << speculations_won << "\n";
+            oss << "locality_hits," << locality_hits << "\n";
+            oss << "locality_misses," << locality_misses << "\n";
+            oss << "tasks_evicted," << tasks_evicted << "\n";
         }
         std::string out = oss.str();
         send(new_socket, out.c_str(), out.size(), 0);
@@ -355,6 +1486,56 @@ void status_server() {
     close(server_fd);
 }
 
+// Routes each accepted connection to the node or client handler. Shared by
+// the TCP listener and the Unix socket listener for co-located nodes.
+void accept_loop(int listen_fd) {
+    while (running) {
+        int new_socket = accept(listen_fd, nullptr, nullptr);
+        if (new_socket < 0) continue;
+
+        // Bound the peek so a silent connection cannot stall the accept loop.
+        timeval peek_tv{1, 0};
+        setsockopt(new_socket, SOL_SOCKET, SO_RCVTIMEO, &peek_tv, sizeof(peek_tv));
+
+        char buffer[1024] = {0};
+        recv(new_socket, buffer, 1023, MSG_PEEK);
+        std::string peek(buffer);
+
+        if (peek.rfind("REGISTER", 0) == 0) {
+            std::thread(handle_node, new_socket).detach();
+        } else if (active_client_handlers >= MAX_CLIENT_HANDLERS) {
+            std::string busy = "BUSY retry_after_ms=" + std::to_string(SCHEDULER_TICK_MS * 5) + "\n";
+            send(new_socket, busy.c_str(), busy.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            close(new_socket);
+        } else {
+            active_client_handlers++;
+            std::thread([new_socket] {
+                handle_client(new_socket);
+                active_client_handlers--;
+            }).detach();
+        }
+    }
+}
+
+// Co-located node agents connect here instead of over loopback TCP.
+int open_local_listener(int port) {
+    local_socket_path = "/tmp/crm_manager_" + std::to_string(port) + ".sock";
+    unlink(local_socket_path.c_str());
+
+    sockaddr_un local_addr{};
+    local_addr.sun_family = AF_UNIX;
+    strncpy(local_addr.sun_path, local_socket_path.c_str(), sizeof(local_addr.sun_path) - 1);
+
+    int local_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (local_fd < 0 || bind(local_fd, (sockaddr *)&local_addr, sizeof(local_addr)) < 0 || listen(local_fd, 10) < 0) {
+        log("WARN", "Manager: Local socket " + local_socket_path + " unavailable, nodes will use TCP.");
+        if (local_fd >= 0) close(local_fd);
+        local_socket_path.clear();
+        return -1;
+    }
+    return local_fd;
+}
+
 int main(int argc, char* argv[]) {
     signal(SIGINT, signal_handler);
 
@@ -367,7 +1548,8 @@ int main(int argc, char* argv[]) {
     std::cout.rdbuf(dual_out.rdbuf());  // Redirect std::cout to dual_out
 
     int port = 5000;
-    if (argc == 2) port = std::stoi(argv[1]);
+    if (argc >= 2) port = std::stoi(argv[1]);
+    if (argc >= 3) overcommit_ratio = std::max(1.0, std::stod(argv[2]));
 
     log("INFO", "Manager starting...");
 
@@ -400,27 +1582,24 @@ int main(int argc, char* argv[]) {
     std::thread assign_thread(assign_tasks);
     std::thread health_thread(health_monitor);
     std::thread status_thread(status_server);
+    std::thread timer_thread(timer_loop);
+    std::thread subscriber_thread(subscriber_monitor);
 
-    while (running) {
-        sockaddr_in client_addr{};
-        socklen_t addrlen = sizeof(client_addr);
-        int new_socket = accept(server_fd, (sockaddr *)&client_addr, &addrlen);
-        if (new_socket < 0) continue;
-
-        char buffer[1024] = {0};
-        recv(new_socket, buffer, 1024, MSG_PEEK);
-        std::string peek(buffer);
-
-        if (peek.rfind("REGISTER", 0) == 0) {
-            std::thread(handle_node, new_socket).detach();
-        } else {
-            std::thread(handle_client, new_socket).detach();
-        }
+    std::thread local_accept_thread;
+    int local_fd = open_local_listener(port);
+    if (local_fd >= 0) {
+        log("INFO", "Manager listening for co-located nodes on " + local_socket_path);
+        local_accept_thread = std::thread(accept_loop, local_fd);
     }
 
+    accept_loop(server_fd);
+
+    if (local_accept_thread.joinable()) local_accept_thread.join();
     assign_thread.join();
     health_thread.join();
     status_thread.join();
+    timer_thread.join();
+    subscriber_thread.join();
     close(server_fd);
     return 0;
 }
@@ -8,15 +8,57 @@
 #include <sstream>
 #include <string>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <thread>
 #include <unistd.h>
 #include <atomic>
 #include <ctime>
+#include <vector>
+#include <set>
+#include <list>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <fstream>
+#include "../../include/bloom_filter.hpp"
 
 std::string node_id;
 int task_listener_fd = -1;
 int manager_fd = -1;
+int local_listener_fd = -1;
+std::string local_socket_path;
 std::atomic<bool> running{true};
+std::mutex cancel_mutex;
+std::set<std::string> cancelled_tasks;  // tasks the manager no longer needs from us
+std::multiset<std::string> received_tasks;  // dispatched here and not finished, guarded by cancel_mutex
+std::mutex manager_send_mutex;          // keeps lines from concurrent senders whole
+
+// Local LRU cache of fetched task inputs, most recently used first.
+const size_t INPUT_CACHE_CAPACITY = 32;
+const int INPUT_FETCH_MS = 500;  // simulated transfer time per uncached input
+std::mutex cache_mutex;
+std::list<std::string> input_cache;
+std::map<std::string, std::list<std::string>::iterator> input_cache_index;
+
+// Memory pressure handling. The manager may overcommit this node based on
+// observed usage, so the node watches its own RSS and evicts work if needed.
+const double PRESSURE_HIGH = 0.90;  // start evicting above this share of capacity
+const double PRESSURE_LOW = 0.75;   // evict until projected usage is below this
+const int USAGE_REPORT_MS = 1000;
+int memory_capacity_mb = 512; // For prototype, hardcoded
+
+struct RunningTask {
+    int priority;  // 1 = deadline work, 0 = best effort
+    std::chrono::steady_clock::time_point started;
+    int used_mb = 0;
+    bool stop = false;     // set by CANCEL or eviction
+    bool evicted = false;
+};
+
+enum class TaskOutcome { DONE, CANCELLED, EVICTED };
+
+std::mutex running_mutex;
+std::map<std::string, RunningTask> running_tasks;
 
 void log(const std::string &level, const std::string &msg) {
     auto t = std::time(nullptr);
@@ -31,31 +73,331 @@ void signal_handler(int signum) {
     log("INFO", "Node " + node_id + ": Shutting down...");
     if (manager_fd != -1) close(manager_fd);
     if (task_listener_fd != -1) close(task_listener_fd);
+    if (local_listener_fd != -1) {
+        close(local_listener_fd);
+        unlink(local_socket_path.c_str());
+    }
     exit(0);
 }
 
-void execute_task(const std::string &task) {
+void send_to_manager(const std::string &msg) {
+    std::lock_guard<std::mutex> lock(manager_send_mutex);
+    send(manager_fd, msg.c_str(), msg.length(), MSG_NOSIGNAL);
+}
+
+// Makes the task's inputs local, fetching only keys that are not cached yet
+// and evicting the least recently used beyond INPUT_CACHE_CAPACITY. When the
+// cache changes, its contents are reported to the manager as a Bloom filter
+// so placement can favour this node for the same inputs.
+void fetch_inputs(const std::string &input_list) {
+    std::vector<std::string> keys, missing;
+    std::istringstream iss(input_list);
+    std::string key;
+    while (std::getline(iss, key, ',')) {
+        if (!key.empty()) keys.push_back(key);
+    }
+    if (keys.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for (const auto &k : keys) {
+            auto c_it = input_cache_index.find(k);
+            if (c_it == input_cache_index.end()) {
+                missing.push_back(k);
+            } else {
+                input_cache.splice(input_cache.begin(), input_cache, c_it->second);
+            }
+        }
+    }
+    log("INFO", "Node " + node_id + ": Inputs " + std::to_string(keys.size() - missing.size()) + " cached, " +
+                std::to_string(missing.size()) + " to fetch");
+    if (missing.empty()) return;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(INPUT_FETCH_MS * missing.size()));
+
+    BloomFilter filter;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for (const auto &k : missing) {
+            if (input_cache_index.count(k)) continue;
+            input_cache.push_front(k);
+            input_cache_index[k] = input_cache.begin();
+        }
+        while (input_cache.size() > INPUT_CACHE_CAPACITY) {
+            input_cache_index.erase(input_cache.back());
+            input_cache.pop_back();
+        }
+        for (const auto &k : input_cache) filter.add(k);
+    }
+    send_to_manager("CACHE " + filter.to_hex() + "\n");
+}
+
+// Consumes a pending cancellation for task, if the manager sent one.
+bool take_cancelled(const std::string &task) {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    return cancelled_tasks.erase(task) > 0;
+}
+
+void mark_received(const std::vector<std::string> &tasks) {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    for (const auto &task : tasks) received_tasks.insert(task);
+}
+
+// Forgets finished tasks along with any cancellation left for them, so a
+// later dispatch of the same ID runs normally.
+void mark_finished(const std::vector<std::string> &tasks) {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    for (const auto &task : tasks) {
+        auto r_it = received_tasks.find(task);
+        if (r_it != received_tasks.end()) received_tasks.erase(r_it);
+        if (received_tasks.count(task) == 0) cancelled_tasks.erase(task);
+    }
+}
+
+// Resident set size of this node process, from /proc/self/statm.
+int read_rss_mb() {
+    std::ifstream statm("/proc/self/statm");
+    long size_pages = 0, resident_pages = 0;
+    if (!(statm >> size_pages >> resident_pages)) return 0;
+    return (int)(resident_pages * sysconf(_SC_PAGESIZE) / (1024 * 1024));
+}
+
+// Simulated workload: runs for about a second holding a share of its
+// declared memory resident. Requests are padded, so a task typically uses
+// well under its declaration. Stops early if cancelled or evicted.
+TaskOutcome run_workload(const std::string &task, int declared_mb, int priority, int &used_mb) {
+    thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_real_distribution<> share(0.2, 0.6);
+    used_mb = std::max(1, (int)(declared_mb * share(gen)));
+    {
+        std::lock_guard<std::mutex> lock(running_mutex);
+        running_tasks[task] = RunningTask{priority, std::chrono::steady_clock::now(), used_mb};
+    }
+
+    std::vector<char> working_set((size_t)used_mb * 1024 * 1024);
+    for (size_t i = 0; i < working_set.size(); i += 4096) working_set[i] = 1;
+
+    TaskOutcome outcome = TaskOutcome::DONE;
+    for (int step = 0; step < 10; ++step) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::lock_guard<std::mutex> lock(running_mutex);
+        const RunningTask &state = running_tasks[task];
+        if (state.stop) {
+            outcome = state.evicted ? TaskOutcome::EVICTED : TaskOutcome::CANCELLED;
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(running_mutex);
+    running_tasks.erase(task);
+    return outcome;
+}
+
+// Stops a running task on the manager's request. Returns false if the task
+// is not running here (it may not have arrived yet).
+bool stop_running(const std::string &task) {
+    std::lock_guard<std::mutex> lock(running_mutex);
+    auto r_it = running_tasks.find(task);
+    if (r_it == running_tasks.end()) return false;
+    r_it->second.stop = true;
+    return true;
+}
+
+// Evicts running tasks, lowest priority and most recently started first,
+// until projected usage falls below PRESSURE_LOW of capacity.
+void evict_for_pressure(int rss_mb) {
+    std::vector<std::pair<std::string, RunningTask *>> candidates;
+    std::lock_guard<std::mutex> lock(running_mutex);
+    for (auto &[task, state] : running_tasks) {
+        if (!state.stop) candidates.push_back({task, &state});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        if (a.second->priority != b.second->priority) return a.second->priority < b.second->priority;
+        return a.second->started > b.second->started;
+    });
+
+    int projected = rss_mb;
+    for (auto &[task, state] : candidates) {
+        if (projected < memory_capacity_mb * PRESSURE_LOW) break;
+        state->stop = true;
+        state->evicted = true;
+        projected -= state->used_mb;
+        log("WARN", "Node " + node_id + ": Evicting task " + task + " (" + std::to_string(state->used_mb) +
+                    " MB) under memory pressure (" + std::to_string(rss_mb) + " MB resident)");
+    }
+}
+
+// Periodically reports resident memory to the manager and evicts work when
+// it approaches the node's capacity.
+void usage_reporter() {
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(USAGE_REPORT_MS));
+        int rss_mb = read_rss_mb();
+        send_to_manager("NODE_USAGE " + std::to_string(rss_mb) + "\n");
+        if (rss_mb >= memory_capacity_mb * PRESSURE_HIGH) evict_for_pressure(rss_mb);
+    }
+}
+
+void execute_task(const std::string &task, int declared_mb, int priority, const std::string &inputs) {
+    if (take_cancelled(task)) {
+        log("INFO", "Node " + node_id + ": Skipping cancelled task: " + task);
+        return;
+    }
     log("INFO", "Node " + node_id + ": Received task: " + task);
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    log("INFO", "Node " + node_id + ": Completed task: " + task);
+    fetch_inputs(inputs);
+    int used_mb = 0;
+    TaskOutcome outcome = run_workload(task, declared_mb, priority, used_mb);
+    if (outcome == TaskOutcome::EVICTED) {
+        send_to_manager("TASK_EVICTED " + task + "\n");
+        return;
+    }
+    if (outcome == TaskOutcome::CANCELLED || take_cancelled(task)) {
+        log("INFO", "Node " + node_id + ": Dropping result of cancelled task: " + task);
+        return;
+    }
+    log("INFO", "Node " + node_id + ": Completed task: " + task + " (used " + std::to_string(used_mb) + " MB)");
+
+    send_to_manager("TASK_USAGE " + task + " " + std::to_string(used_mb) + "\nTASK_DONE " + task + "\n");
+}
+
+// Runs a batch of small tasks side by side (the manager has already reserved
+// memory for all of them) and acknowledges them with a single TASKS_DONE.
+// Items are "<task>:<declared MB>:<priority>".
+void execute_batch(const std::string &task_list) {
+    std::istringstream iss(task_list);
+    std::vector<std::string> batch;
+    std::vector<int> declared, priority;
+    std::string item;
+    while (iss >> item) {
+        std::istringstream fields(item);
+        std::string task, mem_str, prio_str;
+        std::getline(fields, task, ':');
+        std::getline(fields, mem_str, ':');
+        std::getline(fields, prio_str, ':');
+        if (take_cancelled(task)) {
+            log("INFO", "Node " + node_id + ": Skipping cancelled task: " + task);
+            continue;
+        }
+        batch.push_back(task);
+        declared.push_back(std::atoi(mem_str.c_str()));
+        priority.push_back(std::atoi(prio_str.c_str()));
+    }
+    if (batch.empty()) return;
+
+    log("INFO", "Node " + node_id + ": Received batch of " + std::to_string(batch.size()) + " tasks (" +
+                batch.front() + " .. " + batch.back() + ")");
+    std::vector<TaskOutcome> outcomes(batch.size());
+    std::vector<int> used(batch.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        workers.emplace_back([&, i] { outcomes[i] = run_workload(batch[i], declared[i], priority[i], used[i]); });
+    }
+    for (auto &worker : workers) worker.join();
+
+    std::string usage_msg = "TASKS_USAGE", done_msg = "TASKS_DONE", evicted_msg;
+    int completed = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (outcomes[i] == TaskOutcome::EVICTED) {
+            evicted_msg += "TASK_EVICTED " + batch[i] + "\n";
+        } else if (outcomes[i] == TaskOutcome::DONE && !take_cancelled(batch[i])) {
+            usage_msg += " " + batch[i] + ":" + std::to_string(used[i]);
+            done_msg += " " + batch[i];
+            completed++;
+        }
+    }
+    log("INFO", "Node " + node_id + ": Completed batch of " + std::to_string(completed) + " tasks");
+    send_to_manager(evicted_msg + (completed > 0 ? usage_msg + "\n" + done_msg + "\n" : ""));
+}
 
-    std::string clean_task = task;
-    size_t first = clean_task.find_first_not_of(" \t\n\r");
-    size_t last = clean_task.find_last_not_of(" \t\n\r");
-    if (first != std::string::npos)
-        clean_task = clean_task.substr(first, last - first + 1);
-    else
-        clean_task = "";
+// Handles one message from the manager. Returns false on SHUTDOWN.
+bool handle_message(const std::string &raw) {
+    size_t first = raw.find_first_not_of(" \t\n\r");
+    size_t last = raw.find_last_not_of(" \t\n\r");
+    std::string task_raw = (first == std::string::npos) ? "" : raw.substr(first, last - first + 1);
 
-    if (!clean_task.empty()) {
-        std::string done_msg = "TASK_DONE " + clean_task + "\n";
-        send(manager_fd, done_msg.c_str(), done_msg.length(), 0);
+    if (task_raw == "SHUTDOWN") {
+        log("INFO", "Node " + node_id + ": Received shutdown signal from manager.");
+        running = false;
+        // Wake both listeners blocked in accept() so they can exit.
+        if (task_listener_fd != -1) shutdown(task_listener_fd, SHUT_RDWR);
+        if (local_listener_fd != -1) shutdown(local_listener_fd, SHUT_RDWR);
+        return false;
+    } else if (task_raw.rfind("CANCEL ", 0) == 0) {
+        // The manager finished this task elsewhere (speculative copy won).
+        std::string task = task_raw.substr(7);
+        log("INFO", "Node " + node_id + ": Task " + task + " cancelled by manager.");
+        // A task that is not running yet is cancelled when it starts; one
+        // that already finished here needs nothing.
+        if (!stop_running(task)) {
+            std::lock_guard<std::mutex> lock(cancel_mutex);
+            if (received_tasks.count(task)) cancelled_tasks.insert(task);
+        }
+    } else if (task_raw.rfind("BATCH ", 0) == 0) {
+        // Tasks run on their own threads so the connection keeps delivering
+        // work, cancellations and shutdown while they execute.
+        std::string task_list = task_raw.substr(6);
+        std::vector<std::string> batch;
+        std::istringstream items(task_list);
+        std::string item;
+        while (items >> item) batch.push_back(item.substr(0, item.find(':')));
+        mark_received(batch);
+        std::thread([task_list, batch] {
+            execute_batch(task_list);
+            mark_finished(batch);
+        }).detach();
+    } else if (!task_raw.empty()) {
+        // "<task_id>[ mem=<MB>][ prio=<n>][ inputs=<key>,<key>]"
+        std::istringstream fields(task_raw);
+        std::string task, option, inputs;
+        int declared_mb = 0, priority = 0;
+        fields >> task;
+        while (fields >> option) {
+            if (option.rfind("mem=", 0) == 0) declared_mb = std::atoi(option.c_str() + 4);
+            else if (option.rfind("prio=", 0) == 0) priority = std::atoi(option.c_str() + 5);
+            else if (option.rfind("inputs=", 0) == 0) inputs = option.substr(7);
+        }
+        mark_received({task});
+        std::thread([task, declared_mb, priority, inputs] {
+            execute_task(task, declared_mb, priority, inputs);
+            mark_finished({task});
+        }).detach();
+    }
+    return true;
+}
+
+// Reads newline-terminated messages until the manager closes the connection.
+// TCP dispatch uses one connection per message; a co-located manager keeps a
+// single Unix stream open and sends every message on it.
+void serve_connection(int client_fd) {
+    std::string pending;
+    char buffer[4096];
+    ssize_t valread;
+    bool open = true;
+    while (open && (valread = recv(client_fd, buffer, sizeof(buffer), 0)) > 0) {
+        pending.append(buffer, valread);
+        size_t pos;
+        while (open && (pos = pending.find('\n')) != std::string::npos) {
+            open = handle_message(pending.substr(0, pos));
+            pending.erase(0, pos + 1);
+        }
+    }
+    if (open && !pending.empty()) handle_message(pending);
+    close(client_fd);
+}
+
+void serve_tasks(int listener_fd) {
+    while (running) {
+        int client_fd = accept(listener_fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        std::thread(serve_connection, client_fd).detach();
     }
 }
 
 void task_listener(int port) {
-    sockaddr_in server_addr{}, client_addr{};
-    socklen_t client_len = sizeof(client_addr);
+    sockaddr_in server_addr{};
     task_listener_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (task_listener_fd < 0) {
         log("ERROR", "Node " + node_id + ": Failed to create task listener socket.");
@@ -77,37 +419,43 @@ void task_listener(int port) {
     listen(task_listener_fd, 5);
     log("INFO", "Node " + node_id + ": Listening for tasks on port " + std::to_string(port) + "...");
 
-    while (running) {
-        int client_fd = accept(task_listener_fd, (sockaddr *)&client_addr, &client_len);
-        if (client_fd < 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
-        }
+    serve_tasks(task_listener_fd);
+}
 
-        char buffer[1024] = {0};
-        ssize_t valread = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-        if (valread <= 0) {
-            close(client_fd);
-            continue;
-        }
-        buffer[valread] = '\0';
-        std::string task_raw(buffer);
+// Unix-domain twin of task_listener for a manager on the same host; it skips
+// the loopback TCP stack on every dispatch.
+void local_task_listener() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, local_socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(local_socket_path.c_str());
 
-        size_t first = task_raw.find_first_not_of(" \t\n\r");
-        size_t last = task_raw.find_last_not_of(" \t\n\r");
-        task_raw = (first == std::string::npos) ? "" : task_raw.substr(first, last - first + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 5) < 0) {
+        log("WARN", "Node " + node_id + ": Local socket " + local_socket_path + " unavailable, using TCP only.");
+        if (fd >= 0) close(fd);
+        return;
+    }
+    local_listener_fd = fd;
+    log("INFO", "Node " + node_id + ": Listening for local tasks on " + local_socket_path + "...");
 
-        if (task_raw == "SHUTDOWN") {
-            log("INFO", "Node " + node_id + ": Received shutdown signal from manager.");
-            running = false;
-            close(client_fd);
-            break;
-        } else if (!task_raw.empty()) {
-            execute_task(task_raw);
-        }
+    serve_tasks(local_listener_fd);
+}
+
+// The manager listens on /tmp/crm_manager_<port>.sock next to its TCP port.
+int connect_local_manager(int manager_port) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::string path = "/tmp/crm_manager_" + std::to_string(manager_port) + ".sock";
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
 
-        close(client_fd);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
     }
+    return fd;
 }
 
 int main(int argc, char* argv[]) {
@@ -125,32 +473,56 @@ int main(int argc, char* argv[]) {
 
     log("INFO", "NodeAgent " + node_id + ": initialized.");
 
-    sockaddr_in manager_addr{};
-    manager_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (manager_fd < 0) {
-        log("ERROR", "Node " + node_id + ": Failed to create socket to manager.");
-        return 1;
+    bool co_located = manager_ip == "127.0.0.1" || manager_ip == "localhost";
+    if (co_located) {
+        manager_fd = connect_local_manager(manager_port);
+        if (manager_fd >= 0) {
+            log("INFO", "Node " + node_id + ": Connected to manager over local socket.");
+        }
     }
 
-    manager_addr.sin_family = AF_INET;
-    manager_addr.sin_port = htons(manager_port);
-    inet_pton(AF_INET, manager_ip.c_str(), &manager_addr.sin_addr);
+    if (manager_fd < 0) {
+        sockaddr_in manager_addr{};
+        manager_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (manager_fd < 0) {
+            log("ERROR", "Node " + node_id + ": Failed to create socket to manager.");
+            return 1;
+        }
 
-    if (connect(manager_fd, (sockaddr *)&manager_addr, sizeof(manager_addr)) < 0) {
-        log("ERROR", "Node " + node_id + ": Could not connect to manager.");
-        close(manager_fd);
-        return 1;
+        manager_addr.sin_family = AF_INET;
+        manager_addr.sin_port = htons(manager_port);
+        inet_pton(AF_INET, manager_ip.c_str(), &manager_addr.sin_addr);
+
+        if (connect(manager_fd, (sockaddr *)&manager_addr, sizeof(manager_addr)) < 0) {
+            log("ERROR", "Node " + node_id + ": Could not connect to manager.");
+            close(manager_fd);
+            return 1;
+        }
+
+        log("INFO", "Node " + node_id + ": Connected to manager at " + manager_ip + ":" + std::to_string(manager_port));
     }
 
-    log("INFO", "Node " + node_id + ": Connected to manager at " + manager_ip + ":" + std::to_string(manager_port));
+    // Co-located nodes also advertise a Unix socket; the manager uses it for
+    // dispatch when it sees the node is local and falls back to TCP otherwise.
+    std::thread local_listener;
+    if (co_located) {
+        local_socket_path = "/tmp/crm_node_" + node_id + ".sock";
+        local_listener = std::thread(local_task_listener);
+    }
 
-    int available_memory_mb = 512; // For prototype, hardcoded
-    std::string reg_msg = "REGISTER " + node_id + " " + std::to_string(task_port) + " " + std::to_string(available_memory_mb);
+    std::string reg_msg = "REGISTER " + node_id + " " + std::to_string(task_port) + " " + std::to_string(memory_capacity_mb);
+    if (co_located) reg_msg += " LOCAL " + local_socket_path;
     send(manager_fd, reg_msg.c_str(), reg_msg.length(), 0);
     log("INFO", "Node " + node_id + ": Sent registration message to manager with memory info.");
 
+    std::thread(usage_reporter).detach();
     std::thread listener(task_listener, task_port);
     listener.join();
+    if (local_listener.joinable()) local_listener.join();
+    if (local_listener_fd != -1) {
+        close(local_listener_fd);
+        unlink(local_socket_path.c_str());
+    }
 
     log("INFO", "Node " + node_id + ": Shutdown complete.");
     return 0;